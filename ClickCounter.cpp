@@ -0,0 +1,97 @@
+#include "ClickCounter.h"
+#include "URLShortnerDB.h"
+
+#include <functional>
+#include <iostream>
+
+using std::cerr;
+using std::endl;
+using std::lock_guard;
+using std::mutex;
+using std::unique_lock;
+
+ClickCounter::ClickCounter(UrlShortenerDB& db_instance, std::chrono::milliseconds interval, size_t threshold)
+    : db(db_instance), flushInterval(interval), flushThreshold(threshold == 0 ? 1 : threshold) {
+    flusher = std::thread(&ClickCounter::run, this);
+}
+
+ClickCounter::~ClickCounter() {
+    stop();
+}
+
+// Each request thread sticks to one shard, so shards are practically uncontended
+ClickCounter::Shard& ClickCounter::localShard() {
+    thread_local const size_t index = std::hash<std::thread::id>{}(std::this_thread::get_id()) % SHARD_COUNT;
+    return shards[index];
+}
+
+void ClickCounter::record(unsigned int linkId) {
+    Shard& shard = localShard();
+    {
+        lock_guard<mutex> lock(shard.mutex);
+        ++shard.pending[linkId];
+    }
+
+    if (pendingClicks.fetch_add(1, std::memory_order_relaxed) + 1 == flushThreshold) {
+        wakeCv.notify_one();
+    }
+}
+
+void ClickCounter::flush() {
+    lock_guard<mutex> flushLock(flushMutex);
+
+    // Swap every shard out and merge the deltas per link
+    std::unordered_map<unsigned int, unsigned long long> merged;
+    for (auto& shard : shards) {
+        std::unordered_map<unsigned int, unsigned long long> taken;
+        {
+            lock_guard<mutex> lock(shard.mutex);
+            taken.swap(shard.pending);
+        }
+        for (const auto& entry : taken) {
+            merged[entry.first] += entry.second;
+        }
+    }
+    pendingClicks.store(0, std::memory_order_relaxed);
+
+    if (merged.empty()) return;
+
+    std::vector<std::pair<unsigned int, unsigned long long>> deltas(merged.begin(), merged.end());
+    if (!db.addLinkClicks(deltas)) {
+        // Put the deltas back so they are retried on the next flush
+        cerr << "CLICK_ERROR: Failed to flush " << deltas.size() << " link click deltas, will retry." << endl;
+        Shard& shard = localShard();
+        lock_guard<mutex> lock(shard.mutex);
+        for (const auto& delta : deltas) {
+            shard.pending[delta.first] += delta.second;
+            pendingClicks.fetch_add(static_cast<size_t>(delta.second), std::memory_order_relaxed);
+        }
+    }
+}
+
+void ClickCounter::run() {
+    unique_lock<mutex> lock(wakeMutex);
+    while (!stopping) {
+        wakeCv.wait_for(lock, flushInterval, [this] {
+            return stopping || pendingClicks.load(std::memory_order_relaxed) >= flushThreshold;
+        });
+        if (stopping) break;
+
+        lock.unlock();
+        flush();
+        lock.lock();
+    }
+}
+
+void ClickCounter::stop() {
+    {
+        lock_guard<mutex> lock(wakeMutex);
+        if (stopping) return;
+        stopping = true;
+    }
+    wakeCv.notify_one();
+    if (flusher.joinable()) flusher.join();
+
+    // Final flush so pending clicks survive shutdown
+    flush();
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+class UrlShortenerDB;
+
+// Coalesces redirect clicks in memory and writes them to shortened_links
+// in batches from a background thread (Link Analytics).
+//
+// Request threads only bump a counter in their own shard, so a viral link no
+// longer turns into one row-locking UPDATE per click. Pending deltas are
+// flushed every flushInterval, as soon as flushThreshold clicks are buffered,
+// and once more on stop()/destruction so no clicks are lost on shutdown.
+class ClickCounter {
+public:
+    ClickCounter(UrlShortenerDB& db, std::chrono::milliseconds flushInterval, size_t flushThreshold);
+    ~ClickCounter();
+
+    ClickCounter(const ClickCounter&) = delete;
+    ClickCounter& operator=(const ClickCounter&) = delete;
+
+    void record(unsigned int linkId);
+
+    // Writes all pending deltas now (also called by the background thread)
+    void flush();
+
+    // Stops the background thread and flushes what is left
+    void stop();
+
+private:
+    static constexpr size_t SHARD_COUNT = 16;
+
+    struct alignas(64) Shard {
+        std::mutex mutex;
+        std::unordered_map<unsigned int, unsigned long long> pending;
+    };
+
+    Shard& localShard();
+    void run();
+
+    UrlShortenerDB& db;
+    std::chrono::milliseconds flushInterval;
+    size_t flushThreshold;
+
+    std::array<Shard, SHARD_COUNT> shards;
+    std::atomic<size_t> pendingClicks{0};
+
+    std::mutex flushMutex; // Serializes flushes (background thread vs. stop())
+    std::mutex wakeMutex;
+    std::condition_variable wakeCv;
+    bool stopping = false;
+    std::thread flusher;
+};
@@ -0,0 +1,130 @@
+#include "CodeReservoir.h"
+#include "URLShortnerDB.h"
+
+#include <algorithm>
+#include <iostream>
+#include <unordered_set>
+#include <vector>
+
+using std::cerr;
+using std::endl;
+using std::lock_guard;
+using std::mutex;
+using std::string;
+using std::unique_lock;
+
+CodeReservoir::CodeReservoir(UrlShortenerDB& db_instance, std::function<string()> generator,
+                             size_t capacityHint, size_t low, size_t batch)
+    : db(db_instance), generateCode(std::move(generator)), queue(capacityHint),
+      batchSize(std::max<size_t>(1, std::min(batch, queue.capacity()))) {
+    // Below lowWater a full batch must still fit, or run() would wake without ever refilling
+    lowWater = std::max<size_t>(1, std::min(low, queue.capacity() - batchSize + 1));
+    if (lowWater != low || batchSize != batch) {
+        cerr << "RESERVOIR_WARN: Using low water " << lowWater << " and batch " << batchSize
+             << " for capacity " << queue.capacity() << "." << endl;
+    }
+    refiller = std::thread(&CodeReservoir::run, this);
+}
+
+CodeReservoir::~CodeReservoir() {
+    stop();
+}
+
+bool CodeReservoir::pop(string& code) {
+    bool popped = queue.tryPop(code);
+    if (!popped) {
+        emptyPopCount.fetch_add(1, std::memory_order_relaxed);
+    }
+    // Wake the refiller as soon as we cross the low-water mark
+    if (queue.sizeApprox() < lowWater) {
+        wakeCv.notify_one();
+    }
+    return popped;
+}
+
+void CodeReservoir::stop() {
+    {
+        lock_guard<mutex> lock(wakeMutex);
+        if (stopping) return;
+        stopping = true;
+    }
+    wakeCv.notify_one();
+    if (refiller.joinable()) refiller.join();
+}
+
+size_t CodeReservoir::refillBatch() {
+    // Generate distinct candidates
+    std::unordered_set<string> candidates;
+    while (candidates.size() < batchSize) {
+        candidates.insert(generateCode());
+    }
+
+    // Codes the filter proves absent need no DB check at all
+    std::vector<string> free;
+    std::vector<string> toCheck;
+    const ShortCodeFilter* filter = db.getShortCodeFilter();
+    for (const auto& code : candidates) {
+        if (filter && !filter->mightContain(code)) {
+            free.push_back(code);
+        } else {
+            toCheck.push_back(code);
+        }
+    }
+
+    if (!toCheck.empty()) {
+        auto existing = db.findExistingShortCodes(toCheck);
+        if (existing) {
+            std::unordered_set<string> taken(existing->begin(), existing->end());
+            for (auto& code : toCheck) {
+                if (taken.count(code) == 0) free.push_back(std::move(code));
+            }
+        }
+        // On a DB error only the filter-proven codes are used this round
+    }
+
+    size_t pushed = 0;
+    for (auto& code : free) {
+        if (!queue.tryPush(std::move(code))) break; // Full
+        ++pushed;
+    }
+    return pushed;
+}
+
+void CodeReservoir::run() {
+    unique_lock<mutex> lock(wakeMutex);
+    while (!stopping) {
+        // Also poll, since pop() notifies without holding the lock
+        wakeCv.wait_for(lock, std::chrono::milliseconds(100), [this] {
+            return stopping || queue.sizeApprox() < lowWater;
+        });
+        if (stopping) break;
+        lock.unlock();
+
+        // Top up to capacity in batches
+        auto start = std::chrono::steady_clock::now();
+        size_t pushedTotal = 0;
+        while (queue.sizeApprox() + batchSize <= queue.capacity()) {
+            size_t pushed = refillBatch();
+            pushedTotal += pushed;
+            if (pushed == 0) break; // DB trouble: retry on the next wakeup
+            {
+                lock_guard<mutex> stopLock(wakeMutex);
+                if (stopping) break;
+            }
+        }
+
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if (pushedTotal > 0) {
+            refilledCount.fetch_add(pushedTotal, std::memory_order_relaxed);
+            lastRefillRate.store(seconds > 0 ? pushedTotal / seconds : 0.0, std::memory_order_relaxed);
+        } else {
+            cerr << "RESERVOIR_WARN: Refill produced no codes (depth " << queue.sizeApprox() << ")." << endl;
+            // Back off so a DB outage does not turn into a busy loop
+            lock.lock();
+            wakeCv.wait_for(lock, std::chrono::seconds(1), [this] { return stopping; });
+            continue;
+        }
+
+        lock.lock();
+    }
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "MpmcQueue.h"
+
+class UrlShortenerDB;
+
+// Reservoir of pre-validated, unused random short codes.
+//
+// A background thread keeps the queue above lowWater: it generates a batch
+// of candidates, accepts those the short code filter proves unused, checks
+// the rest with a single SELECT ... WHERE short_code IN (...), and pushes
+// the free ones. Request threads only pop, so creation latency stays flat
+// when the keyspace is dense or a burst of shorten requests arrives.
+// A code taken by another instance since the check (or not yet synced into
+// the filter) is caught by the UNIQUE index, and the caller retries.
+class CodeReservoir {
+public:
+    CodeReservoir(UrlShortenerDB& db, std::function<std::string()> generator,
+                  size_t capacity, size_t lowWater, size_t batchSize);
+    ~CodeReservoir();
+
+    CodeReservoir(const CodeReservoir&) = delete;
+    CodeReservoir& operator=(const CodeReservoir&) = delete;
+
+    // Pops a code; false if the reservoir ran dry (caller falls back to probing)
+    bool pop(std::string& code);
+    void stop();
+
+    size_t depth() const { return queue.sizeApprox(); }
+    size_t capacity() const { return queue.capacity(); }
+    unsigned long long refilled() const { return refilledCount.load(std::memory_order_relaxed); }
+    unsigned long long emptyPops() const { return emptyPopCount.load(std::memory_order_relaxed); }
+    double refillRate() const { return lastRefillRate.load(std::memory_order_relaxed); } // codes/sec of the last pass
+
+private:
+    void run();
+    size_t refillBatch();
+
+    UrlShortenerDB& db;
+    std::function<std::string()> generateCode;
+    MpmcQueue<std::string> queue;
+    size_t batchSize; // In [1, capacity]
+    size_t lowWater;  // In [1, capacity - batchSize + 1]
+
+    std::atomic<unsigned long long> refilledCount{0};
+    std::atomic<unsigned long long> emptyPopCount{0};
+    std::atomic<double> lastRefillRate{0.0};
+
+    std::mutex wakeMutex;
+    std::condition_variable wakeCv;
+    bool stopping = false;
+    std::thread refiller;
+};
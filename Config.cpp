@@ -22,6 +22,23 @@ const std::string Config::DB_USER = getEnv("DB_USER", "root");
 const std::string Config::DB_PASS = getEnv("DB_PASS", "Prashant"); // Using the hardcoded value as a local fallback
 const std::string Config::DB_NAME = getEnv("DB_NAME", "test_url"); 
 const int Config::DB_PORT = std::stoi(getEnv("DB_PORT", "33060")); 
+// Sessions opened at startup (in parallel) and kept warm; the pool grows on demand up to DB_POOL_MAX
+const int Config::DB_POOL_MIN = std::stoi(getEnv("DB_POOL_MIN", "10"));
+const int Config::DB_POOL_MAX = std::stoi(getEnv("DB_POOL_MAX", "32"));
+// How long a request waits for a session before failing
+const int Config::DB_POOL_ACQUIRE_TIMEOUT_MS = std::stoi(getEnv("DB_POOL_ACQUIRE_TIMEOUT_MS", "5000"));
+// Sessions above DB_POOL_MIN idle this long are closed
+const int Config::DB_POOL_IDLE_TIMEOUT_SECONDS = std::stoi(getEnv("DB_POOL_IDLE_TIMEOUT_SECONDS", "300"));
+// Idle sessions are pinged this often, and on checkout when not checked for this long
+const int Config::DB_POOL_VALIDATION_INTERVAL_SECONDS = std::stoi(getEnv("DB_POOL_VALIDATION_INTERVAL_SECONDS", "30"));
+// Read replicas as "host:port,host:port" (same user, password and schema as the primary); empty = primary only
+const std::string Config::DB_REPLICAS = getEnv("DB_REPLICAS", "");
+// Reads of rows this instance wrote within this window go to the primary (covers replication lag)
+const int Config::READ_YOUR_WRITES_WINDOW_MS = std::stoi(getEnv("READ_YOUR_WRITES_WINDOW_MS", "5000"));
+// global_settings is cached in memory and reloaded this often (or via POST /api/admin/settings/reload)
+const int Config::SETTINGS_REFRESH_SECONDS = std::stoi(getEnv("SETTINGS_REFRESH_SECONDS", "60"));
+// Guest quotas are enforced in memory and written to guest_daily_quotas this often
+const int Config::GUEST_QUOTA_FLUSH_INTERVAL_MS = std::stoi(getEnv("GUEST_QUOTA_FLUSH_INTERVAL_MS", "1000"));
 
 // Application URLs and Secrets
 const std::string Config::BASE_URL = getEnv("BASE_URL", "http://localhost:9080/");
@@ -34,3 +51,73 @@ const std::string Config::GOOGLE_REDIRECT_URI = getEnv("GOOGLE_REDIRECT_URI", "h
 // Non-sensitive Configuration
 const std::size_t Config::MAX_URL_LENGTH = 2048;
 const int Config::LINK_EXPIRED_IN = 30; // Defined as the default in Config.h, but kept here for completeness
+
+// Redirect cache (number of short codes kept in memory)
+const std::size_t Config::LINK_CACHE_CAPACITY = std::stoul(getEnv("LINK_CACHE_CAPACITY", "100000"));
+// Cached links are re-read after at most this long, so deletions on other instances are seen (0 = until expiry)
+const long Config::LINK_CACHE_MAX_AGE_SECONDS = std::stol(getEnv("LINK_CACHE_MAX_AGE_SECONDS", "60"));
+
+// Session token cache: valid sessions are kept until expires_at but at most MAX_AGE (so logouts on other
+// instances are seen), unknown tokens for NEGATIVE_TTL
+const std::size_t Config::SESSION_CACHE_CAPACITY = std::stoul(getEnv("SESSION_CACHE_CAPACITY", "100000"));
+const long Config::SESSION_CACHE_MAX_AGE_SECONDS = std::stol(getEnv("SESSION_CACHE_MAX_AGE_SECONDS", "300"));
+const long Config::SESSION_CACHE_NEGATIVE_TTL_SECONDS = std::stol(getEnv("SESSION_CACHE_NEGATIVE_TTL_SECONDS", "30"));
+
+// Signed session tokens (opt-in): "kid:secret,kid:secret" and the kid used for new tokens. Empty keeps the
+// opaque DB-backed tokens. Revocations made on other instances are picked up every SYNC_SECONDS.
+const std::string Config::SESSION_TOKEN_KEYS = getEnv("SESSION_TOKEN_KEYS", "");
+const std::string Config::SESSION_TOKEN_ACTIVE_KEY = getEnv("SESSION_TOKEN_ACTIVE_KEY", "");
+const int Config::TOKEN_REVOCATION_SYNC_SECONDS = std::stoi(getEnv("TOKEN_REVOCATION_SYNC_SECONDS", "10"));
+
+// Click counting: buffered clicks are written every interval or once the threshold is reached
+const int Config::CLICK_FLUSH_INTERVAL_MS = std::stoi(getEnv("CLICK_FLUSH_INTERVAL_MS", "1000"));
+const std::size_t Config::CLICK_FLUSH_THRESHOLD = std::stoul(getEnv("CLICK_FLUSH_THRESHOLD", "10000"));
+
+// Endpoint stats are counted per thread and written as one upsert every interval
+const int Config::ENDPOINT_STATS_FLUSH_INTERVAL_MS = std::stoi(getEnv("ENDPOINT_STATS_FLUSH_INTERVAL_MS", "5000"));
+
+// Per-IP rate limiting: tokens per second, bucket size, and the most clients tracked at once
+const double Config::RATE_LIMIT_RATE = std::stod(getEnv("RATE_LIMIT_RATE", "2.0"));
+const double Config::RATE_LIMIT_BURST = std::stod(getEnv("RATE_LIMIT_BURST", "10.0"));
+const std::size_t Config::RATE_LIMIT_MAX_CLIENTS = std::stoul(getEnv("RATE_LIMIT_MAX_CLIENTS", "100000"));
+
+// Short code existence filter (expected number of codes, 0 = off) and target false-positive rate.
+// Codes created by other instances are picked up every SYNC_SECONDS; until then they may 404 here.
+const std::size_t Config::SHORT_CODE_FILTER_CAPACITY = std::stoul(getEnv("SHORT_CODE_FILTER_CAPACITY", "0"));
+const double Config::SHORT_CODE_FILTER_FPR = std::stod(getEnv("SHORT_CODE_FILTER_FPR", "0.01"));
+const int Config::SHORT_CODE_FILTER_SYNC_SECONDS = std::stoi(getEnv("SHORT_CODE_FILTER_SYNC_SECONDS", "5"));
+
+// Memory-mapped link snapshot built by snapshot_gen (empty = disabled)
+const std::string Config::LINK_SNAPSHOT_PATH = getEnv("LINK_SNAPSHOT_PATH", "");
+// Deletions made by other instances stop being served from the snapshot within SYNC_SECONDS.
+// Their tombstones are kept RETENTION_DAYS; older snapshots are refused.
+const int Config::LINK_SNAPSHOT_SYNC_SECONDS = std::stoi(getEnv("LINK_SNAPSHOT_SYNC_SECONDS", "5"));
+const int Config::LINK_TOMBSTONE_RETENTION_DAYS = std::stoi(getEnv("LINK_TOMBSTONE_RETENTION_DAYS", "30"));
+
+// Short code allocation: ids leased per block from id_sequences, scrambled with a secret key.
+// There is no default key: without one the codes could be enumerated, so "sequence" falls back to "random".
+const unsigned long long Config::SHORT_CODE_BLOCK_SIZE = std::stoull(getEnv("SHORT_CODE_BLOCK_SIZE", "10000"));
+const unsigned long long Config::SHORT_CODE_SCRAMBLE_KEY = std::stoull(getEnv("SHORT_CODE_SCRAMBLE_KEY", "0"));
+
+// "sequence" = block-leased ids (default, needs SHORT_CODE_SCRAMBLE_KEY), "random" = random codes from the pre-validated reservoir
+const std::string Config::SHORT_CODE_STRATEGY = getEnv("SHORT_CODE_STRATEGY", "sequence");
+const std::size_t Config::SHORT_CODE_RESERVOIR_SIZE = std::stoul(getEnv("SHORT_CODE_RESERVOIR_SIZE", "8192"));
+const std::size_t Config::SHORT_CODE_RESERVOIR_LOW_WATER = std::stoul(getEnv("SHORT_CODE_RESERVOIR_LOW_WATER", "2048"));
+const std::size_t Config::SHORT_CODE_RESERVOIR_BATCH = std::stoul(getEnv("SHORT_CODE_RESERVOIR_BATCH", "500"));
+// Group commit for POST /shorten: rows are collected this long and inserted in one transaction (0 = off, ~2 is a good start)
+const int Config::LINK_GROUP_COMMIT_WINDOW_MS = std::stoi(getEnv("LINK_GROUP_COMMIT_WINDOW_MS", "0"));
+// A batch is committed early once this many rows are queued
+const std::size_t Config::LINK_GROUP_COMMIT_MAX_ROWS = std::stoul(getEnv("LINK_GROUP_COMMIT_MAX_ROWS", "100"));
+
+// Dedupe: re-shortening a URL the same user/guest already has a live generated link for returns that link.
+// The in-memory url -> code index holds at most DEDUPE_INDEX_CAPACITY entries, misses go to the url_hash index.
+const bool Config::DEDUPE_LINKS = getEnv("DEDUPE_LINKS", "false") == "true";
+const std::size_t Config::DEDUPE_INDEX_CAPACITY = std::stoul(getEnv("DEDUPE_INDEX_CAPACITY", "100000"));
+
+// Request logging: records buffered in a ring (dropped when full) and written every interval.
+// With SENTRY_DSN set, a sampled share of requests is also sent to Sentry, capped per second.
+const std::string Config::SENTRY_DSN = getEnv("SENTRY_DSN", "");
+const std::size_t Config::LOG_RING_CAPACITY = std::stoul(getEnv("LOG_RING_CAPACITY", "8192"));
+const int Config::LOG_FLUSH_INTERVAL_MS = std::stoi(getEnv("LOG_FLUSH_INTERVAL_MS", "50"));
+const double Config::LOG_SENTRY_SAMPLE_RATE = std::stod(getEnv("LOG_SENTRY_SAMPLE_RATE", "0.01"));
+const unsigned int Config::LOG_SENTRY_MAX_PER_SECOND = static_cast<unsigned int>(std::stoul(getEnv("LOG_SENTRY_MAX_PER_SECOND", "10")));
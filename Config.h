@@ -9,9 +9,53 @@ public:
     static const std::string DB_PASS;
     static const std::string DB_NAME;
     static const int DB_PORT;
+    static const int DB_POOL_MIN;
+    static const int DB_POOL_MAX;
+    static const int DB_POOL_ACQUIRE_TIMEOUT_MS;
+    static const int DB_POOL_IDLE_TIMEOUT_SECONDS;
+    static const int DB_POOL_VALIDATION_INTERVAL_SECONDS;
+    static const std::string DB_REPLICAS;
+    static const int READ_YOUR_WRITES_WINDOW_MS;
+    static const int SETTINGS_REFRESH_SECONDS;
+    static const int GUEST_QUOTA_FLUSH_INTERVAL_MS;
     static const std::string BASE_URL;
     static const size_t MAX_URL_LENGTH;
     static const int LINK_EXPIRED_IN;
+    static const size_t LINK_CACHE_CAPACITY;
+    static const long LINK_CACHE_MAX_AGE_SECONDS;
+    static const size_t SESSION_CACHE_CAPACITY;
+    static const long SESSION_CACHE_MAX_AGE_SECONDS;
+    static const long SESSION_CACHE_NEGATIVE_TTL_SECONDS;
+    static const std::string SESSION_TOKEN_KEYS;
+    static const std::string SESSION_TOKEN_ACTIVE_KEY;
+    static const int TOKEN_REVOCATION_SYNC_SECONDS;
+    static const int CLICK_FLUSH_INTERVAL_MS;
+    static const size_t CLICK_FLUSH_THRESHOLD;
+    static const int ENDPOINT_STATS_FLUSH_INTERVAL_MS;
+    static const double RATE_LIMIT_RATE;
+    static const double RATE_LIMIT_BURST;
+    static const size_t RATE_LIMIT_MAX_CLIENTS;
+    static const size_t SHORT_CODE_FILTER_CAPACITY;
+    static const double SHORT_CODE_FILTER_FPR;
+    static const int SHORT_CODE_FILTER_SYNC_SECONDS;
+    static const std::string LINK_SNAPSHOT_PATH;
+    static const int LINK_SNAPSHOT_SYNC_SECONDS;
+    static const int LINK_TOMBSTONE_RETENTION_DAYS;
+    static const unsigned long long SHORT_CODE_BLOCK_SIZE;
+    static const unsigned long long SHORT_CODE_SCRAMBLE_KEY;
+    static const std::string SHORT_CODE_STRATEGY;
+    static const size_t SHORT_CODE_RESERVOIR_SIZE;
+    static const size_t SHORT_CODE_RESERVOIR_LOW_WATER;
+    static const size_t SHORT_CODE_RESERVOIR_BATCH;
+    static const int LINK_GROUP_COMMIT_WINDOW_MS;
+    static const size_t LINK_GROUP_COMMIT_MAX_ROWS;
+    static const bool DEDUPE_LINKS;
+    static const size_t DEDUPE_INDEX_CAPACITY;
+    static const std::string SENTRY_DSN;
+    static const size_t LOG_RING_CAPACITY;
+    static const int LOG_FLUSH_INTERVAL_MS;
+    static const double LOG_SENTRY_SAMPLE_RATE;
+    static const unsigned int LOG_SENTRY_MAX_PER_SECOND;
     static const std::string GOOGLE_CLIENT_ID;
     static const std::string GOOGLE_REDIRECT_URI;
     static const std::string GOOGLE_CLIENT_SECRET;
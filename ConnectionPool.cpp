@@ -0,0 +1,335 @@
+#include "ConnectionPool.h"
+
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+
+using std::cerr;
+using std::endl;
+using std::lock_guard;
+using std::mutex;
+using std::unique_lock;
+using std::unique_ptr;
+using Clock = std::chrono::steady_clock;
+
+constexpr std::array<uint64_t, 9> ConnectionPool::WAIT_BUCKETS_US;
+
+ConnectionPool::ConnectionPool(Factory sessionFactory, const Options& opts, const std::string& schema,
+                               StatementCacheStats& stats)
+    : factory(std::move(sessionFactory)), options(opts), schemaName(schema), statementStats(stats) {
+    options.minSize = std::max<size_t>(1, options.minSize);
+    options.maxSize = std::max(options.minSize, options.maxSize);
+    idle.reserve(options.maxSize);
+}
+
+ConnectionPool::~ConnectionPool() {
+    stop();
+}
+
+unique_ptr<mysqlx::Session> ConnectionPool::open() {
+    unique_ptr<mysqlx::Session> session = factory();
+    adopt(session);
+    openedCount.fetch_add(1, std::memory_order_relaxed);
+    return session;
+}
+
+void ConnectionPool::adopt(unique_ptr<mysqlx::Session>& session) {
+    auto cache = std::make_unique<StatementCache>(*session, schemaName, statementStats);
+    std::unique_lock<std::shared_mutex> lock(statementsMutex);
+    statements[session.get()] = std::move(cache);
+}
+
+void ConnectionPool::discard(unique_ptr<mysqlx::Session> session, bool broken) {
+    const mysqlx::Session* raw = session.get();
+    {
+        std::unique_lock<std::shared_mutex> lock(statementsMutex);
+        statements.erase(session.get());
+    }
+    try {
+        session->close();
+    } catch (const std::exception&) {
+        // Already dead, nothing to close
+    }
+    session.reset();
+
+    (broken ? brokenCount : closedCount).fetch_add(1, std::memory_order_relaxed);
+    unique_lock<mutex> lock(poolMutex);
+    checkedOut.erase(raw);
+    --total;
+    handOffCapacity(lock);
+}
+
+bool ConnectionPool::ping(mysqlx::Session& session) {
+    try {
+        session.sql("SELECT 1").execute();
+        return true;
+    } catch (const std::exception&) {
+        return false;
+    }
+}
+
+// Lets the oldest waiter open a session of its own when the pool has room
+void ConnectionPool::handOffCapacity(unique_lock<mutex>&) {
+    if (!waiters.empty() && total < options.maxSize) {
+        Waiter* waiter = waiters.front();
+        waiters.pop_front();
+        ++total;
+        waiter->mayOpen = true;
+        waiter->cv.notify_one();
+    }
+}
+
+bool ConnectionPool::start() {
+    // Open the initial sessions in parallel; each connect is a few network round-trips
+    std::vector<std::thread> openers;
+    openers.reserve(options.minSize);
+    for (size_t i = 0; i < options.minSize; ++i) {
+        openers.emplace_back([this] {
+            try {
+                unique_ptr<mysqlx::Session> session = open();
+                lock_guard<mutex> lock(poolMutex);
+                ++total;
+                idle.push_back(Idle{std::move(session), Clock::now(), Clock::now()});
+            } catch (const std::exception& e) {
+                cerr << "DB_ERROR: Failed to open pooled session: " << e.what() << endl;
+            }
+        });
+    }
+    for (auto& opener : openers) opener.join();
+
+    size_t opened;
+    {
+        lock_guard<mutex> lock(poolMutex);
+        opened = total;
+    }
+    if (opened == 0) return false;
+    if (opened < options.minSize) {
+        cerr << "DB_WARN: Only " << opened << " of " << options.minSize << " pooled sessions opened, maintenance will retry." << endl;
+    }
+
+    maintenance = std::thread(&ConnectionPool::run, this);
+    return true;
+}
+
+void ConnectionPool::stop() {
+    {
+        lock_guard<mutex> lock(wakeMutex);
+        if (stopping) return;
+        stopping = true;
+    }
+    wakeCv.notify_one();
+    if (maintenance.joinable()) maintenance.join();
+}
+
+unique_ptr<mysqlx::Session> ConnectionPool::acquire() {
+    return acquire(Clock::now() + options.acquireTimeout);
+}
+
+unique_ptr<mysqlx::Session> ConnectionPool::acquire(Clock::time_point deadline) {
+    const auto started = Clock::now();
+
+    for (;;) {
+        unique_ptr<mysqlx::Session> session;
+        bool openNew = false;
+        bool validate = false;
+        bool handedOver = false; // Passed on by a releaser, checkedOut already holds it
+        Clock::time_point lastChecked;
+        {
+            unique_lock<mutex> lock(poolMutex);
+            if (waiters.empty() && !idle.empty()) {
+                // Most recently returned first, so surplus sessions age out and get trimmed
+                Idle entry = std::move(idle.back());
+                idle.pop_back();
+                validate = Clock::now() - entry.lastChecked >= options.validationInterval;
+                lastChecked = entry.lastChecked;
+                session = std::move(entry.session);
+            } else if (waiters.empty() && total < options.maxSize) {
+                ++total;
+                openNew = true;
+            } else {
+                Waiter waiter;
+                waiters.push_back(&waiter);
+                while (!waiter.session && !waiter.mayOpen) {
+                    if (waiter.cv.wait_until(lock, deadline) == std::cv_status::timeout &&
+                        !waiter.session && !waiter.mayOpen) {
+                        waiters.erase(std::find(waiters.begin(), waiters.end(), &waiter));
+                        timeoutCount.fetch_add(1, std::memory_order_relaxed);
+                        throw std::runtime_error("Database pool timeout: No connections available.");
+                    }
+                }
+                openNew = waiter.mayOpen;
+                handedOver = !openNew;
+                session = std::move(waiter.session);
+            }
+        }
+
+        if (openNew) {
+            try {
+                session = open();
+            } catch (...) {
+                unique_lock<mutex> lock(poolMutex);
+                --total;
+                handOffCapacity(lock);
+                throw;
+            }
+        } else if (validate && !ping(*session)) {
+            // Dead while idle: replace it and try again
+            discard(std::move(session), true);
+            if (Clock::now() >= deadline) {
+                timeoutCount.fetch_add(1, std::memory_order_relaxed);
+                throw std::runtime_error("Database pool timeout: No healthy connections available.");
+            }
+            continue;
+        }
+
+        if (openNew || validate) lastChecked = Clock::now();
+        if (!handedOver) {
+            lock_guard<mutex> lock(poolMutex);
+            checkedOut[session.get()] = lastChecked;
+        }
+
+        recordWait(Clock::now() - started);
+        acquiredCount.fetch_add(1, std::memory_order_relaxed);
+        return session;
+    }
+}
+
+void ConnectionPool::release(unique_ptr<mysqlx::Session> session, bool broken) {
+    if (!session) return;
+    if (broken) {
+        cerr << "DB_WARN: Pooled session lost its connection, replacing it." << endl;
+        discard(std::move(session), true);
+        return;
+    }
+    lock_guard<mutex> lock(poolMutex);
+    if (!waiters.empty()) {
+        // Direct hand-off keeps the wait queue strictly FIFO
+        Waiter* waiter = waiters.front();
+        waiters.pop_front();
+        waiter->session = std::move(session);
+        waiter->cv.notify_one();
+        return;
+    }
+    auto now = Clock::now();
+    auto checked = checkedOut.find(session.get());
+    Clock::time_point lastChecked = now; // Freshly opened by maintain()
+    if (checked != checkedOut.end()) {
+        lastChecked = checked->second;
+        checkedOut.erase(checked);
+    }
+    idle.push_back(Idle{std::move(session), now, lastChecked});
+}
+
+StatementCache& ConnectionPool::statementsFor(mysqlx::Session& session) {
+    std::shared_lock<std::shared_mutex> lock(statementsMutex);
+    auto it = statements.find(&session);
+    if (it == statements.end()) {
+        throw std::runtime_error("Session is not part of the pool.");
+    }
+    return *it->second;
+}
+
+void ConnectionPool::recordWait(Clock::duration waited) {
+    uint64_t micros = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(waited).count());
+    size_t bucket = std::upper_bound(WAIT_BUCKETS_US.begin(), WAIT_BUCKETS_US.end(), micros) - WAIT_BUCKETS_US.begin();
+    waitHistogram[bucket].fetch_add(1, std::memory_order_relaxed);
+}
+
+void ConnectionPool::maintain() {
+    auto now = Clock::now();
+    std::vector<Idle> toCheck;
+    std::vector<unique_ptr<mysqlx::Session>> toTrim;
+    {
+        lock_guard<mutex> lock(poolMutex);
+        size_t keep = total;
+        // Oldest idle sessions sit at the front
+        auto it = idle.begin();
+        while (it != idle.end()) {
+            if (keep > options.minSize && now - it->since >= options.idleTimeout) {
+                toTrim.push_back(std::move(it->session));
+                --keep;
+                it = idle.erase(it);
+            } else if (now - it->lastChecked >= options.validationInterval) {
+                toCheck.push_back(std::move(*it));
+                it = idle.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+
+    for (auto& session : toTrim) {
+        discard(std::move(session), false);
+    }
+
+    for (auto& entry : toCheck) {
+        if (!ping(*entry.session)) {
+            cerr << "DB_WARN: Pooled session failed its health check, replacing it." << endl;
+            discard(std::move(entry.session), true);
+            continue;
+        }
+        lock_guard<mutex> lock(poolMutex);
+        if (!waiters.empty()) {
+            Waiter* waiter = waiters.front();
+            waiters.pop_front();
+            checkedOut[entry.session.get()] = Clock::now();
+            waiter->session = std::move(entry.session);
+            waiter->cv.notify_one();
+        } else {
+            // Keep the original idle time so trimming still sees it as idle
+            idle.insert(idle.begin(), Idle{std::move(entry.session), entry.since, Clock::now()});
+        }
+    }
+
+    // Top back up to the minimum (replaces broken and failed-to-open sessions)
+    for (;;) {
+        {
+            lock_guard<mutex> lock(poolMutex);
+            if (total >= options.minSize) break;
+            ++total;
+        }
+        try {
+            release(open());
+        } catch (const std::exception& e) {
+            cerr << "DB_ERROR: Failed to replenish the pool: " << e.what() << endl;
+            unique_lock<mutex> lock(poolMutex);
+            --total;
+            handOffCapacity(lock);
+            break;
+        }
+    }
+}
+
+void ConnectionPool::run() {
+    // Check at least every 5 seconds so idle trimming stays timely with long validation intervals
+    auto period = std::min<Clock::duration>(options.validationInterval, std::chrono::seconds(5));
+    unique_lock<mutex> lock(wakeMutex);
+    while (!stopping) {
+        wakeCv.wait_for(lock, period, [this] { return stopping; });
+        if (stopping) break;
+
+        lock.unlock();
+        maintain();
+        lock.lock();
+    }
+}
+
+ConnectionPool::Stats ConnectionPool::stats() const {
+    Stats result;
+    {
+        lock_guard<mutex> lock(poolMutex);
+        result.total = total;
+        result.idle = idle.size();
+        result.inUse = total - idle.size();
+        result.waiters = waiters.size();
+    }
+    result.acquired = acquiredCount.load(std::memory_order_relaxed);
+    result.timeouts = timeoutCount.load(std::memory_order_relaxed);
+    result.opened = openedCount.load(std::memory_order_relaxed);
+    result.closed = closedCount.load(std::memory_order_relaxed);
+    result.broken = brokenCount.load(std::memory_order_relaxed);
+    for (size_t i = 0; i < waitHistogram.size(); ++i) {
+        result.waitHistogram[i] = waitHistogram[i].load(std::memory_order_relaxed);
+    }
+    return result;
+}
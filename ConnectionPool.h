@@ -0,0 +1,132 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <mysqlx/xdevapi.h>
+
+#include "StatementCache.h"
+
+// Elastic pool of MySQL X sessions.
+//
+// - Starts with minSize sessions opened in parallel and grows on demand up
+//   to maxSize; sessions are opened outside the pool lock.
+// - Callers that find no idle session wait in FIFO order: a released
+//   session is handed straight to the oldest waiter, so there are no
+//   stolen wakeups. Each acquire() has its own deadline.
+// - A maintenance thread pings idle sessions, replaces broken ones, trims
+//   sessions idle longer than idleTimeout down to minSize, and tops the
+//   pool back up to minSize. Sessions idle longer than the validation
+//   interval are also pinged on checkout before being handed out. A session
+//   released as broken is closed and replaced instead of reused.
+// - Every session owns a StatementCache (see statementsFor()).
+class ConnectionPool {
+public:
+    using Factory = std::function<std::unique_ptr<mysqlx::Session>()>;
+
+    struct Options {
+        size_t minSize = 10;
+        size_t maxSize = 32;
+        std::chrono::milliseconds acquireTimeout{5000};
+        std::chrono::seconds idleTimeout{300};
+        std::chrono::seconds validationInterval{30};
+    };
+
+    // Checkout wait-time histogram bucket upper bounds, in microseconds (last bucket is open-ended)
+    static constexpr std::array<uint64_t, 9> WAIT_BUCKETS_US = {100, 1000, 5000, 10000, 50000, 100000, 500000, 1000000, 5000000};
+
+    struct Stats {
+        size_t total = 0;
+        size_t idle = 0;
+        size_t inUse = 0;
+        size_t waiters = 0;
+        unsigned long long acquired = 0;
+        unsigned long long timeouts = 0;
+        unsigned long long opened = 0;
+        unsigned long long closed = 0;
+        unsigned long long broken = 0;
+        std::array<unsigned long long, WAIT_BUCKETS_US.size() + 1> waitHistogram{};
+    };
+
+    ConnectionPool(Factory factory, const Options& options, const std::string& schema, StatementCacheStats& statementStats);
+    ~ConnectionPool();
+
+    ConnectionPool(const ConnectionPool&) = delete;
+    ConnectionPool& operator=(const ConnectionPool&) = delete;
+
+    // Opens minSize sessions in parallel and starts maintenance; false if none could be opened
+    bool start();
+    void stop();
+
+    // Throws std::runtime_error when no session could be obtained before the deadline
+    std::unique_ptr<mysqlx::Session> acquire();
+    std::unique_ptr<mysqlx::Session> acquire(std::chrono::steady_clock::time_point deadline);
+    // broken: the session failed with a connection-level error and is closed instead of reused
+    void release(std::unique_ptr<mysqlx::Session> session, bool broken = false);
+
+    // Reusable statements of a session obtained from this pool
+    StatementCache& statementsFor(mysqlx::Session& session);
+
+    Stats stats() const;
+
+private:
+    struct Idle {
+        std::unique_ptr<mysqlx::Session> session;
+        std::chrono::steady_clock::time_point since;       // Returned to the pool
+        std::chrono::steady_clock::time_point lastChecked; // Last known alive
+    };
+
+    struct Waiter {
+        std::condition_variable cv;
+        std::unique_ptr<mysqlx::Session> session;
+        bool mayOpen = false; // Woken because capacity freed up: open a new session
+    };
+
+    std::unique_ptr<mysqlx::Session> open();
+    void adopt(std::unique_ptr<mysqlx::Session>& session);
+    void discard(std::unique_ptr<mysqlx::Session> session, bool broken);
+    static bool ping(mysqlx::Session& session);
+    void recordWait(std::chrono::steady_clock::duration waited);
+    void handOffCapacity(std::unique_lock<std::mutex>& lock);
+    void maintain();
+    void run();
+
+    Factory factory;
+    Options options;
+    std::string schemaName;
+    StatementCacheStats& statementStats;
+
+    mutable std::mutex poolMutex;
+    std::vector<Idle> idle; // Back = most recently returned
+    std::deque<Waiter*> waiters;
+    size_t total = 0;       // Open sessions, idle + in use + being opened
+    // lastChecked of sessions in use, restored on release so use does not count as a health check
+    std::unordered_map<const mysqlx::Session*, std::chrono::steady_clock::time_point> checkedOut;
+
+    mutable std::shared_mutex statementsMutex;
+    std::unordered_map<const mysqlx::Session*, std::unique_ptr<StatementCache>> statements;
+
+    std::atomic<unsigned long long> acquiredCount{0};
+    std::atomic<unsigned long long> timeoutCount{0};
+    std::atomic<unsigned long long> openedCount{0};
+    std::atomic<unsigned long long> closedCount{0};
+    std::atomic<unsigned long long> brokenCount{0};
+    std::array<std::atomic<unsigned long long>, WAIT_BUCKETS_US.size() + 1> waitHistogram{};
+
+    std::mutex wakeMutex;
+    std::condition_variable wakeCv;
+    bool stopping = false;
+    std::thread maintenance;
+};
@@ -0,0 +1,148 @@
+#include "EndpointStats.h"
+#include "URLShortnerDB.h"
+
+#include <iostream>
+
+using std::cerr;
+using std::endl;
+using std::lock_guard;
+using std::mutex;
+using std::string;
+using std::unique_lock;
+
+namespace {
+
+uint64_t hashKey(const string& endpoint, const string& method) {
+    uint64_t hash = 1469598103934665603ULL;
+    for (unsigned char c : method) {
+        hash = (hash ^ c) * 1099511628211ULL;
+    }
+    hash = (hash ^ 0xff) * 1099511628211ULL; // Separator so ("GE","T/x") != ("GET","/x")
+    for (unsigned char c : endpoint) {
+        hash = (hash ^ c) * 1099511628211ULL;
+    }
+    return hash;
+}
+
+} // namespace
+
+EndpointStats::EndpointStats(UrlShortenerDB& db_instance, std::chrono::milliseconds interval)
+    : db(db_instance), flushInterval(interval) {
+    aggregator = std::thread(&EndpointStats::run, this);
+}
+
+EndpointStats::~EndpointStats() {
+    stop();
+}
+
+EndpointStats::ThreadSlot& EndpointStats::localSlot() {
+    // Registered once per thread; the registry keeps the slot alive so counts
+    // of exited threads are still flushed.
+    thread_local const EndpointStats* owner = nullptr;
+    thread_local std::shared_ptr<ThreadSlot> slot;
+    if (owner != this) {
+        slot = std::make_shared<ThreadSlot>();
+        owner = this;
+        lock_guard<mutex> lock(registryMutex);
+        slots.push_back(slot);
+    }
+    return *slot;
+}
+
+void EndpointStats::record(const string& endpoint, const string& method, const string& clientIp) {
+    uint64_t key = hashKey(endpoint, method);
+    ThreadSlot& slot = localSlot();
+    lock_guard<mutex> lock(slot.mutex);
+
+    auto& chain = slot.counters[key];
+    for (auto& counter : chain) {
+        if (counter.endpoint == endpoint && counter.method == method) {
+            ++counter.count;
+            counter.lastClient = clientIp;
+            return;
+        }
+    }
+    chain.push_back(Counter{endpoint, method, clientIp, 1});
+}
+
+void EndpointStats::flush() {
+    lock_guard<mutex> flushLock(flushMutex);
+
+    std::vector<std::shared_ptr<ThreadSlot>> snapshot;
+    {
+        lock_guard<mutex> lock(registryMutex);
+        snapshot = slots;
+    }
+
+    // Merge all thread slots into one delta per (endpoint, method)
+    CounterMap merged;
+    for (auto& slot : snapshot) {
+        CounterMap taken;
+        {
+            lock_guard<mutex> lock(slot->mutex);
+            taken.swap(slot->counters);
+        }
+        for (auto& entry : taken) {
+            auto& chain = merged[entry.first];
+            for (auto& counter : entry.second) {
+                bool found = false;
+                for (auto& existing : chain) {
+                    if (existing.endpoint == counter.endpoint && existing.method == counter.method) {
+                        existing.count += counter.count;
+                        existing.lastClient = std::move(counter.lastClient);
+                        found = true;
+                        break;
+                    }
+                }
+                if (!found) chain.push_back(std::move(counter));
+            }
+        }
+    }
+
+    std::vector<EndpointStat> stats;
+    for (auto& entry : merged) {
+        for (auto& counter : entry.second) {
+            EndpointStat stat;
+            stat.endpoint = std::move(counter.endpoint);
+            stat.endpoint_type = std::move(counter.method);
+            stat.count = counter.count;
+            stat.created_by = std::move(counter.lastClient);
+            stats.push_back(std::move(stat));
+        }
+    }
+    if (stats.empty()) return;
+
+    if (!db.addEndpointStats(stats)) {
+        // Keep the counts for the next round
+        cerr << "STATS_ERROR: Failed to flush " << stats.size() << " endpoint stats, will retry." << endl;
+        ThreadSlot& slot = localSlot();
+        lock_guard<mutex> lock(slot.mutex);
+        for (auto& stat : stats) {
+            slot.counters[hashKey(stat.endpoint, stat.endpoint_type)].push_back(
+                Counter{stat.endpoint, stat.endpoint_type, stat.created_by, stat.count});
+        }
+    }
+}
+
+void EndpointStats::run() {
+    unique_lock<mutex> lock(wakeMutex);
+    while (!stopping) {
+        wakeCv.wait_for(lock, flushInterval, [this] { return stopping; });
+        if (stopping) break;
+
+        lock.unlock();
+        flush();
+        lock.lock();
+    }
+}
+
+void EndpointStats::stop() {
+    {
+        lock_guard<mutex> lock(wakeMutex);
+        if (stopping) return;
+        stopping = true;
+    }
+    wakeCv.notify_one();
+    if (aggregator.joinable()) aggregator.join();
+    flush();
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+class UrlShortenerDB;
+
+// Endpoint statistics collected in per-thread counters and written to
+// endpoint_stats by a background aggregator with one multi-row upsert.
+//
+// record() only hashes (endpoint, method) and bumps a counter in the calling
+// thread's own cache-line-aligned slot; the slot lock is uncontended except
+// for the instant the aggregator swaps the slot's map out.
+class EndpointStats {
+public:
+    EndpointStats(UrlShortenerDB& db, std::chrono::milliseconds flushInterval);
+    ~EndpointStats();
+
+    EndpointStats(const EndpointStats&) = delete;
+    EndpointStats& operator=(const EndpointStats&) = delete;
+
+    void record(const std::string& endpoint, const std::string& method, const std::string& clientIp);
+
+    void flush();
+    void stop(); // Stops the aggregator and flushes what is left
+
+private:
+    struct Counter {
+        std::string endpoint;
+        std::string method;
+        std::string lastClient;
+        unsigned long long count = 0;
+    };
+
+    // Keyed by the hash of (endpoint, method); collisions chain in the vector
+    using CounterMap = std::unordered_map<uint64_t, std::vector<Counter>>;
+
+    struct alignas(64) ThreadSlot {
+        std::mutex mutex;
+        CounterMap counters;
+    };
+
+    ThreadSlot& localSlot();
+    void run();
+
+    UrlShortenerDB& db;
+    std::chrono::milliseconds flushInterval;
+
+    std::mutex registryMutex;
+    std::vector<std::shared_ptr<ThreadSlot>> slots;
+
+    std::mutex flushMutex;
+    std::mutex wakeMutex;
+    std::condition_variable wakeCv;
+    bool stopping = false;
+    std::thread aggregator;
+};
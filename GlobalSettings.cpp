@@ -0,0 +1,76 @@
+#include "GlobalSettings.h"
+#include "URLShortnerDB.h"
+
+#include <iostream>
+
+using std::cerr;
+using std::endl;
+using std::lock_guard;
+using std::mutex;
+using std::unique_lock;
+
+GlobalSettingsCache::GlobalSettingsCache(UrlShortenerDB& db_instance, std::chrono::seconds interval)
+    : db(db_instance), refreshInterval(interval), snapshot(std::make_shared<const GlobalSettingsSnapshot>()) {
+    refresher = std::thread(&GlobalSettingsCache::run, this);
+}
+
+GlobalSettingsCache::~GlobalSettingsCache() {
+    stop();
+}
+
+bool GlobalSettingsCache::reload() {
+    lock_guard<mutex> reloadLock(reloadMutex);
+
+    auto rows = db.getGlobalSettings();
+    if (!rows) {
+        cerr << "CONFIG_WARN: Could not reload global_settings, keeping the previous values." << endl;
+        return false;
+    }
+
+    auto fresh = std::make_shared<GlobalSettingsSnapshot>();
+    for (auto& row : *rows) {
+        fresh->values[row.setting_key] = std::move(row.setting_value);
+    }
+
+    auto it = fresh->values.find("MAX_LINK_LIMIT_ENABLED");
+    if (it != fresh->values.end()) {
+        fresh->maxLinkLimitEnabled = (it->second == "true");
+    }
+    it = fresh->values.find("MAX_GUEST_LINKS_PER_DAY");
+    if (it != fresh->values.end()) {
+        try {
+            fresh->maxGuestLinksPerDay = static_cast<unsigned int>(std::stoi(it->second));
+        } catch (const std::exception&) {
+            cerr << "CONFIG_WARN: MAX_GUEST_LINKS_PER_DAY is not a number, using " << fresh->maxGuestLinksPerDay << "." << endl;
+        }
+    } else {
+        cerr << "CONFIG_WARN: MAX_GUEST_LINKS_PER_DAY is not set, using " << fresh->maxGuestLinksPerDay << "." << endl;
+    }
+
+    fresh->loadedAt = std::time(nullptr);
+    fresh->version = std::atomic_load(&snapshot)->version + 1;
+    std::atomic_store(&snapshot, std::shared_ptr<const GlobalSettingsSnapshot>(std::move(fresh)));
+    return true;
+}
+
+void GlobalSettingsCache::run() {
+    unique_lock<mutex> lock(wakeMutex);
+    while (!stopping) {
+        wakeCv.wait_for(lock, refreshInterval, [this] { return stopping; });
+        if (stopping) break;
+
+        lock.unlock();
+        reload();
+        lock.lock();
+    }
+}
+
+void GlobalSettingsCache::stop() {
+    {
+        lock_guard<mutex> lock(wakeMutex);
+        if (stopping) return;
+        stopping = true;
+    }
+    wakeCv.notify_one();
+    if (refresher.joinable()) refresher.join();
+}
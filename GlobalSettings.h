@@ -0,0 +1,58 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <ctime>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+class UrlShortenerDB;
+
+// One immutable, typed copy of the global_settings table
+struct GlobalSettingsSnapshot {
+    bool maxLinkLimitEnabled = true;       // MAX_LINK_LIMIT_ENABLED
+    unsigned int maxGuestLinksPerDay = 5;  // MAX_GUEST_LINKS_PER_DAY
+    std::unordered_map<std::string, std::string> values; // Every row, for getConfig(key)
+    std::time_t loadedAt = 0;              // 0 = defaults, never loaded
+    uint64_t version = 0;
+};
+
+// In-memory global_settings, read without any I/O.
+//
+// Readers take the current snapshot with one atomic shared_ptr load; a
+// reload builds a new snapshot off to the side and swaps it in, so readers
+// never see a half-updated table. Reloaded every refreshInterval by a
+// background thread and on demand (admin trigger). A failed reload keeps
+// the previous snapshot.
+class GlobalSettingsCache {
+public:
+    GlobalSettingsCache(UrlShortenerDB& db, std::chrono::seconds refreshInterval);
+    ~GlobalSettingsCache();
+
+    GlobalSettingsCache(const GlobalSettingsCache&) = delete;
+    GlobalSettingsCache& operator=(const GlobalSettingsCache&) = delete;
+
+    std::shared_ptr<const GlobalSettingsSnapshot> current() const { return std::atomic_load(&snapshot); }
+
+    // Loads the table into a new snapshot (also called by the background thread)
+    bool reload();
+    void stop();
+
+private:
+    void run();
+
+    UrlShortenerDB& db;
+    std::chrono::seconds refreshInterval;
+
+    std::shared_ptr<const GlobalSettingsSnapshot> snapshot; // Only accessed with std::atomic_load/store
+
+    std::mutex reloadMutex;
+    std::mutex wakeMutex;
+    std::condition_variable wakeCv;
+    bool stopping = false;
+    std::thread refresher;
+};
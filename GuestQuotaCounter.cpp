@@ -0,0 +1,177 @@
+#include "GuestQuotaCounter.h"
+#include "URLShortnerDB.h"
+
+#include <functional>
+#include <iostream>
+
+using std::cerr;
+using std::endl;
+using std::lock_guard;
+using std::mutex;
+using std::string;
+using std::unique_lock;
+
+namespace {
+// Never lowers the counter, other threads may have moved it further
+void raiseTo(std::atomic<uint32_t>& value, uint32_t target) {
+    uint32_t current = value.load(std::memory_order_relaxed);
+    while (current < target && !value.compare_exchange_weak(current, target, std::memory_order_relaxed)) {
+    }
+}
+}
+
+GuestQuotaCounter::GuestQuotaCounter(UrlShortenerDB& db_instance, std::chrono::milliseconds interval)
+    : db(db_instance), flushInterval(interval) {
+    flusher = std::thread(&GuestQuotaCounter::run, this);
+}
+
+GuestQuotaCounter::~GuestQuotaCounter() {
+    stop();
+}
+
+std::shared_ptr<GuestQuotaCounter::Day> GuestQuotaCounter::dayFor(const string& date) {
+    // Dates compare as strings (YYYY-MM-DD). Requests still carrying the
+    // previous date right after midnight count against the current day.
+    auto current = std::atomic_load(&today);
+    if (current && date <= current->date) return current;
+
+    lock_guard<mutex> lock(rolloverMutex);
+    current = std::atomic_load(&today);
+    if (current && date <= current->date) return current;
+
+    auto fresh = std::make_shared<Day>(date);
+    if (current) retired.push_back(current); // Dropped once its last deltas are written
+    std::atomic_store(&today, fresh);
+    return fresh;
+}
+
+GuestQuotaCounter::Counter& GuestQuotaCounter::counterFor(Day& day, const string& guest) {
+    Shard& shard = day.shards[std::hash<string>{}(guest) % SHARD_COUNT];
+    {
+        std::shared_lock<std::shared_mutex> lock(shard.mutex);
+        auto it = shard.counters.find(guest);
+        if (it != shard.counters.end()) return *it->second;
+    }
+    std::unique_lock<std::shared_mutex> lock(shard.mutex);
+    auto& slot = shard.counters[guest];
+    if (!slot) slot = std::make_unique<Counter>();
+    return *slot;
+}
+
+bool GuestQuotaCounter::tryConsume(const string& guest, const string& date, unsigned int limit) {
+    auto day = dayFor(date);
+    Counter& counter = counterFor(*day, guest);
+
+    uint32_t used = counter.used.load(std::memory_order_relaxed);
+    do {
+        if (used >= limit) {
+            rejectedCount.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+    } while (!counter.used.compare_exchange_weak(used, used + 1, std::memory_order_relaxed));
+
+    counter.unflushed.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+bool GuestQuotaCounter::load(const string& date) {
+    auto rows = db.getGuestQuotas(date);
+    if (!rows) {
+        cerr << "QUOTA_WARN: Could not load guest quotas for " << date << ", starting from zero." << endl;
+        return false;
+    }
+
+    auto day = dayFor(date);
+    for (const auto& row : *rows) {
+        raiseTo(counterFor(*day, row.guest_identifier).used, row.links_created);
+    }
+    cerr << "DB_INFO: Loaded " << rows->size() << " guest quotas for " << date << "." << endl;
+    return true;
+}
+
+bool GuestQuotaCounter::flushDay(Day& day) {
+    std::vector<std::pair<string, unsigned int>> deltas;
+    std::vector<Counter*> taken;
+    for (auto& shard : day.shards) {
+        std::shared_lock<std::shared_mutex> lock(shard.mutex);
+        for (auto& entry : shard.counters) {
+            uint32_t delta = entry.second->unflushed.exchange(0, std::memory_order_relaxed);
+            if (delta == 0) continue;
+            deltas.emplace_back(entry.first, delta);
+            taken.push_back(entry.second.get());
+        }
+    }
+    if (deltas.empty()) return true;
+
+    std::unordered_map<string, unsigned int> totals;
+    if (!db.addGuestQuotaUsage(day.date, deltas, totals)) {
+        // Keep the deltas for the next flush
+        flushFailureCount.fetch_add(1, std::memory_order_relaxed);
+        cerr << "QUOTA_ERROR: Failed to write " << deltas.size() << " guest quota deltas, will retry." << endl;
+        for (size_t i = 0; i < taken.size(); ++i) {
+            taken[i]->unflushed.fetch_add(deltas[i].second, std::memory_order_relaxed);
+        }
+        return false;
+    }
+
+    // Fold in what other instances counted for these guests
+    for (size_t i = 0; i < taken.size(); ++i) {
+        auto it = totals.find(deltas[i].first);
+        if (it != totals.end()) raiseTo(taken[i]->used, it->second);
+    }
+    return true;
+}
+
+void GuestQuotaCounter::flush() {
+    lock_guard<mutex> flushLock(flushMutex);
+
+    std::vector<std::shared_ptr<Day>> previous;
+    {
+        lock_guard<mutex> lock(rolloverMutex);
+        previous.swap(retired);
+    }
+    for (auto& day : previous) {
+        if (!flushDay(*day)) {
+            lock_guard<mutex> lock(rolloverMutex);
+            retired.push_back(day);
+        }
+    }
+
+    if (auto current = std::atomic_load(&today)) {
+        flushDay(*current);
+    }
+}
+
+void GuestQuotaCounter::run() {
+    unique_lock<mutex> lock(wakeMutex);
+    while (!stopping) {
+        wakeCv.wait_for(lock, flushInterval, [this] { return stopping; });
+        if (stopping) break;
+
+        lock.unlock();
+        flush();
+        lock.lock();
+    }
+}
+
+void GuestQuotaCounter::stop() {
+    {
+        lock_guard<mutex> lock(wakeMutex);
+        if (stopping) return;
+        stopping = true;
+    }
+    wakeCv.notify_one();
+    if (flusher.joinable()) flusher.join();
+    flush();
+}
+
+size_t GuestQuotaCounter::trackedGuests() const {
+    auto current = std::atomic_load(&today);
+    if (!current) return 0;
+    size_t total = 0;
+    for (const auto& shard : current->shards) {
+        std::shared_lock<std::shared_mutex> lock(shard.mutex);
+        total += shard.counters.size();
+    }
+    return total;
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+class UrlShortenerDB;
+
+// Per-day guest link quota (guest_daily_quotas) enforced in memory.
+//
+// tryConsume() is a lookup plus a compare-and-swap on the guest's counter,
+// with no I/O. Each counter also remembers how much of it has not been
+// written yet. A background thread adds those deltas to guest_daily_quotas
+// in batches. It reads the stored totals back, so usage by other instances
+// is folded in and raises the local count. The day being enforced is
+// reloaded from the table at startup.
+//
+// Counters live in a per-day table: rolling over to a new date swaps one
+// pointer, and the old day is dropped after its last deltas are flushed.
+class GuestQuotaCounter {
+public:
+    GuestQuotaCounter(UrlShortenerDB& db, std::chrono::milliseconds flushInterval);
+    ~GuestQuotaCounter();
+
+    GuestQuotaCounter(const GuestQuotaCounter&) = delete;
+    GuestQuotaCounter& operator=(const GuestQuotaCounter&) = delete;
+
+    // Counts one link for the guest on `date` (YYYY-MM-DD) unless it already reached `limit`
+    bool tryConsume(const std::string& guest, const std::string& date, unsigned int limit);
+
+    // Replaces the counters with the stored usage for `date`
+    bool load(const std::string& date);
+
+    // Writes pending deltas now (also called by the background thread)
+    void flush();
+    // Stops the background thread and flushes what is left
+    void stop();
+
+    size_t trackedGuests() const;
+    unsigned long long rejected() const { return rejectedCount.load(std::memory_order_relaxed); }
+    unsigned long long flushFailures() const { return flushFailureCount.load(std::memory_order_relaxed); }
+
+private:
+    static constexpr size_t SHARD_COUNT = 64;
+
+    struct Counter {
+        std::atomic<uint32_t> used{0};
+        std::atomic<uint32_t> unflushed{0}; // Counted here, not yet in guest_daily_quotas
+    };
+
+    struct alignas(64) Shard {
+        mutable std::shared_mutex mutex; // Guards the map; counters are atomic
+        std::unordered_map<std::string, std::unique_ptr<Counter>> counters;
+    };
+
+    struct Day {
+        explicit Day(std::string d) : date(std::move(d)) {}
+        const std::string date;
+        std::array<Shard, SHARD_COUNT> shards;
+    };
+
+    std::shared_ptr<Day> dayFor(const std::string& date);
+    static Counter& counterFor(Day& day, const std::string& guest);
+    bool flushDay(Day& day);
+    void run();
+
+    UrlShortenerDB& db;
+    std::chrono::milliseconds flushInterval;
+
+    std::shared_ptr<Day> today; // Only accessed with std::atomic_load/store
+    std::mutex rolloverMutex;
+    std::vector<std::shared_ptr<Day>> retired; // Rolled-over days with deltas still to flush; guarded by rolloverMutex
+
+    std::atomic<unsigned long long> rejectedCount{0};
+    std::atomic<unsigned long long> flushFailureCount{0};
+
+    std::mutex flushMutex; // Serializes flushes (background thread vs. stop())
+    std::mutex wakeMutex;
+    std::condition_variable wakeCv;
+    bool stopping = false;
+    std::thread flusher;
+};
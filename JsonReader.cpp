@@ -0,0 +1,321 @@
+#include "JsonReader.h"
+
+#include "JsonScan.h"
+
+#include <cstdint>
+
+namespace {
+
+int hexValue(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+// Four hex digits at p (already validated by parse())
+uint32_t readHex4(const char* p) {
+    return (hexValue(p[0]) << 12) | (hexValue(p[1]) << 8) | (hexValue(p[2]) << 4) | hexValue(p[3]);
+}
+
+void appendUtf8(std::string& out, uint32_t cp) {
+    if (cp < 0x80) {
+        out += static_cast<char>(cp);
+    } else if (cp < 0x800) {
+        out += static_cast<char>(0xC0 | (cp >> 6));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    } else if (cp < 0x10000) {
+        out += static_cast<char>(0xE0 | (cp >> 12));
+        out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    } else {
+        out += static_cast<char>(0xF0 | (cp >> 18));
+        out += static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+        out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    }
+}
+
+bool isDigit(char c) { return c >= '0' && c <= '9'; }
+
+} // namespace
+
+bool JsonReader::fail(const char* message) {
+    if (!errorMessage) {
+        errorMessage = message;
+        errorAt = pos;
+    }
+    return false;
+}
+
+void JsonReader::skipSpace() {
+    while (pos < text.size()) {
+        char c = text[pos];
+        if (c != ' ' && c != '\t' && c != '\n' && c != '\r') break;
+        ++pos;
+    }
+}
+
+bool JsonReader::parse() {
+    pos = 0;
+    memberCount = 0;
+    errorMessage = nullptr;
+    errorAt = 0;
+
+    skipSpace();
+    if (pos >= text.size() || text[pos] != '{') return fail("expected an object");
+    ++pos;
+    skipSpace();
+
+    if (pos < text.size() && text[pos] == '}') {
+        ++pos;
+    } else {
+        for (;;) {
+            if (pos >= text.size() || text[pos] != '"') return fail("expected a member name");
+            Member member;
+            if (!parseString(member.key, member.keyEscaped)) return false;
+
+            skipSpace();
+            if (pos >= text.size() || text[pos] != ':') return fail("expected ':'");
+            ++pos;
+            skipSpace();
+
+            if (pos < text.size() && text[pos] == '"') {
+                member.type = Type::String;
+                if (!parseString(member.value, member.valueEscaped)) return false;
+            } else {
+                size_t start = pos;
+                if (!parseValue(1, member.type)) return false;
+                member.value = text.substr(start, pos - start);
+            }
+
+            if (memberCount == MAX_MEMBERS) return fail("too many members");
+            members[memberCount++] = member;
+
+            skipSpace();
+            if (pos < text.size() && text[pos] == ',') {
+                ++pos;
+                skipSpace();
+                continue;
+            }
+            if (pos < text.size() && text[pos] == '}') {
+                ++pos;
+                break;
+            }
+            return fail("expected ',' or '}'");
+        }
+    }
+
+    skipSpace();
+    if (pos != text.size()) return fail("unexpected data after the object");
+    return true;
+}
+
+// pos is on the opening quote; leaves pos after the closing one
+bool JsonReader::parseString(std::string_view& out, bool& escaped) {
+    ++pos;
+    const size_t start = pos;
+    escaped = false;
+
+    for (;;) {
+        pos = jsonScanSpecial(text.data(), pos, text.size());
+        if (pos >= text.size()) return fail("unterminated string");
+
+        char c = text[pos];
+        if (c == '"') {
+            out = text.substr(start, pos - start);
+            ++pos;
+            return true;
+        }
+        if (c != '\\') return fail("control character in string");
+
+        escaped = true;
+        if (pos + 1 >= text.size()) return fail("unterminated string");
+        switch (text[pos + 1]) {
+            case '"': case '\\': case '/': case 'b': case 'f': case 'n': case 'r': case 't':
+                pos += 2;
+                break;
+            case 'u':
+                if (pos + 6 > text.size()) return fail("truncated \\u escape");
+                for (size_t i = pos + 2; i < pos + 6; ++i) {
+                    if (hexValue(text[i]) < 0) return fail("invalid \\u escape");
+                }
+                pos += 6;
+                break;
+            default:
+                return fail("invalid escape");
+        }
+    }
+}
+
+bool JsonReader::parseNumber() {
+    if (text[pos] == '-') ++pos;
+    if (pos >= text.size() || !isDigit(text[pos])) return fail("invalid number");
+    if (text[pos] == '0') {
+        ++pos;
+    } else {
+        while (pos < text.size() && isDigit(text[pos])) ++pos;
+    }
+    if (pos < text.size() && text[pos] == '.') {
+        ++pos;
+        if (pos >= text.size() || !isDigit(text[pos])) return fail("invalid number");
+        while (pos < text.size() && isDigit(text[pos])) ++pos;
+    }
+    if (pos < text.size() && (text[pos] == 'e' || text[pos] == 'E')) {
+        ++pos;
+        if (pos < text.size() && (text[pos] == '+' || text[pos] == '-')) ++pos;
+        if (pos >= text.size() || !isDigit(text[pos])) return fail("invalid number");
+        while (pos < text.size() && isDigit(text[pos])) ++pos;
+    }
+    return true;
+}
+
+bool JsonReader::parseLiteral(std::string_view word) {
+    if (text.compare(pos, word.size(), word) != 0) return fail("invalid literal");
+    pos += word.size();
+    return true;
+}
+
+bool JsonReader::parseValue(size_t depth, Type& type) {
+    if (pos >= text.size()) return fail("expected a value");
+
+    std::string_view ignored;
+    bool escaped = false;
+    switch (text[pos]) {
+        case '"':
+            type = Type::String;
+            return parseString(ignored, escaped);
+        case 't':
+            type = Type::True;
+            return parseLiteral("true");
+        case 'f':
+            type = Type::False;
+            return parseLiteral("false");
+        case 'n':
+            type = Type::Null;
+            return parseLiteral("null");
+        case '{':
+        case '[': {
+            const bool isObject = text[pos] == '{';
+            const char close = isObject ? '}' : ']';
+            type = isObject ? Type::Object : Type::Array;
+            if (depth >= MAX_DEPTH) return fail("nested too deeply");
+            ++pos;
+            skipSpace();
+            if (pos < text.size() && text[pos] == close) {
+                ++pos;
+                return true;
+            }
+            for (;;) {
+                if (isObject) {
+                    if (pos >= text.size() || text[pos] != '"') return fail("expected a member name");
+                    if (!parseString(ignored, escaped)) return false;
+                    skipSpace();
+                    if (pos >= text.size() || text[pos] != ':') return fail("expected ':'");
+                    ++pos;
+                    skipSpace();
+                }
+                Type inner;
+                if (!parseValue(depth + 1, inner)) return false;
+                skipSpace();
+                if (pos < text.size() && text[pos] == ',') {
+                    ++pos;
+                    skipSpace();
+                    continue;
+                }
+                if (pos < text.size() && text[pos] == close) {
+                    ++pos;
+                    return true;
+                }
+                return fail(isObject ? "expected ',' or '}'" : "expected ',' or ']'");
+            }
+        }
+        default:
+            if (text[pos] == '-' || isDigit(text[pos])) {
+                type = Type::Number;
+                return parseNumber();
+            }
+            return fail("expected a value");
+    }
+}
+
+bool JsonReader::decode(std::string_view raw, std::string& out) {
+    out.clear();
+    out.reserve(raw.size());
+    for (size_t i = 0; i < raw.size(); ++i) {
+        char c = raw[i];
+        if (c != '\\') {
+            out += c;
+            continue;
+        }
+        char e = raw[++i];
+        switch (e) {
+            case 'b': out += '\b'; break;
+            case 'f': out += '\f'; break;
+            case 'n': out += '\n'; break;
+            case 'r': out += '\r'; break;
+            case 't': out += '\t'; break;
+            case 'u': {
+                uint32_t cp = readHex4(raw.data() + i + 1);
+                i += 4;
+                if (cp >= 0xD800 && cp <= 0xDBFF) {
+                    // High surrogate, must be followed by \u + low surrogate
+                    if (i + 6 >= raw.size() || raw[i + 1] != '\\' || raw[i + 2] != 'u') return false;
+                    uint32_t low = readHex4(raw.data() + i + 3);
+                    if (low < 0xDC00 || low > 0xDFFF) return false;
+                    cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+                    i += 6;
+                } else if (cp >= 0xDC00 && cp <= 0xDFFF) {
+                    return false; // Lone low surrogate
+                }
+                appendUtf8(out, cp);
+                break;
+            }
+            default: out += e; break; // '"', '\\', '/'
+        }
+    }
+    return true;
+}
+
+const JsonReader::Member* JsonReader::find(std::string_view key) const {
+    // Last one wins when a key repeats
+    std::string decoded;
+    for (size_t i = memberCount; i-- > 0;) {
+        const Member& member = members[i];
+        if (!member.keyEscaped) {
+            if (member.key == key) return &member;
+        } else if (decode(member.key, decoded) && decoded == key) {
+            return &member;
+        }
+    }
+    return nullptr;
+}
+
+std::string_view JsonReader::getString(std::string_view key, std::string& scratch) const {
+    const Member* member = find(key);
+    if (!member || member->type != Type::String) return {};
+    if (!member->valueEscaped) return member->value;
+    if (!decode(member->value, scratch)) return {};
+    return scratch;
+}
+
+std::string JsonReader::getString(std::string_view key) const {
+    std::string scratch;
+    std::string_view value = getString(key, scratch);
+    if (value.data() == scratch.data()) return scratch;
+    return std::string(value);
+}
+
+bool JsonReader::getBool(std::string_view key, bool& out) const {
+    const Member* member = find(key);
+    if (!member) return false;
+    if (member->type == Type::True) {
+        out = true;
+        return true;
+    }
+    if (member->type == Type::False) {
+        out = false;
+        return true;
+    }
+    return false;
+}
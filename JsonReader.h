@@ -0,0 +1,71 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+// Validating single-pass reader for the small JSON objects the server takes
+// in: request bodies and the Google token/userinfo responses.
+//
+// parse() walks the body once, checks that it is exactly one well-formed
+// object and records where each top-level member's key and value are. Values
+// are string_views into the body, so nothing is copied or allocated. The one
+// exception is a string that contains escapes: it is decoded when read.
+// Nested objects and arrays are validated and exposed as raw text only.
+//
+// String scanning looks for '"', '\\' and control characters 32 (AVX2) or 16
+// (SSE2) bytes at a time when the build targets x86, and byte by byte
+// otherwise.
+class JsonReader {
+public:
+    enum class Type : char { String, Number, True, False, Null, Object, Array };
+
+    static constexpr size_t MAX_MEMBERS = 64; // Top-level members, more is rejected
+    static constexpr size_t MAX_DEPTH = 32;   // Nesting, more is rejected
+
+    // The body must outlive the reader and every view it returns
+    explicit JsonReader(std::string_view body) : text(body) {}
+
+    // False if the body is not a single well-formed JSON object
+    bool parse();
+    // Why parse() failed and at which byte, for logs
+    const char* error() const { return errorMessage ? errorMessage : ""; }
+    size_t errorOffset() const { return errorAt; }
+
+    bool has(std::string_view key) const { return find(key) != nullptr; }
+    // The member's string value. Escaped strings are decoded into scratch and
+    // the view points there. Empty if missing, not a string or badly encoded.
+    std::string_view getString(std::string_view key, std::string& scratch) const;
+    // Copy of the string value, for values that outlive the body
+    std::string getString(std::string_view key) const;
+    // Sets out only when the member is a JSON boolean
+    bool getBool(std::string_view key, bool& out) const;
+
+private:
+    struct Member {
+        std::string_view key;    // Between the quotes, still escaped
+        std::string_view value;  // Strings: between the quotes, still escaped. Others: raw text
+        Type type = Type::Null;
+        bool keyEscaped = false;
+        bool valueEscaped = false;
+    };
+
+    const Member* find(std::string_view key) const;
+    bool fail(const char* message);
+    void skipSpace();
+    bool parseString(std::string_view& out, bool& escaped);
+    bool parseNumber();
+    bool parseLiteral(std::string_view word);
+    bool parseValue(size_t depth, Type& type);
+
+    // Decodes the contents of a validated JSON string (without the quotes)
+    static bool decode(std::string_view raw, std::string& out);
+
+    std::string_view text;
+    size_t pos = 0;
+    std::array<Member, MAX_MEMBERS> members;
+    size_t memberCount = 0;
+    const char* errorMessage = nullptr;
+    size_t errorAt = 0;
+};
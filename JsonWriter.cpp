@@ -0,0 +1,120 @@
+#include "JsonWriter.h"
+#include "JsonScan.h"
+
+#include <charconv>
+#include <cmath>
+#include <cstdio>
+
+void JsonWriter::separate() {
+    if (afterKey) {
+        afterKey = false;
+        return;
+    }
+    if (depth > 0 && depth < MAX_DEPTH) {
+        const uint64_t bit = uint64_t(1) << depth;
+        if (hasItems & bit) out += ',';
+        hasItems |= bit;
+    }
+}
+
+JsonWriter& JsonWriter::open(char bracket) {
+    separate();
+    out += bracket;
+    ++depth;
+    if (depth < MAX_DEPTH) hasItems &= ~(uint64_t(1) << depth);
+    return *this;
+}
+
+JsonWriter& JsonWriter::close(char bracket) {
+    --depth;
+    out += bracket;
+    return *this;
+}
+
+JsonWriter& JsonWriter::key(std::string_view name) {
+    separate();
+    appendString(out, name);
+    out += ':';
+    afterKey = true;
+    return *this;
+}
+
+JsonWriter& JsonWriter::value(std::string_view text) {
+    separate();
+    appendString(out, text);
+    return *this;
+}
+
+JsonWriter& JsonWriter::value(bool flag) {
+    separate();
+    out += flag ? "true" : "false";
+    return *this;
+}
+
+JsonWriter& JsonWriter::value(double number) {
+    separate();
+    if (!std::isfinite(number)) {
+        out += "null";
+        return *this;
+    }
+    char digits[32];
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+    auto result = std::to_chars(digits, digits + sizeof(digits), number);
+    out.append(digits, result.ptr);
+#else
+    int length = std::snprintf(digits, sizeof(digits), "%.17g", number);
+    out.append(digits, length);
+#endif
+    return *this;
+}
+
+JsonWriter& JsonWriter::null() {
+    separate();
+    out += "null";
+    return *this;
+}
+
+JsonWriter& JsonWriter::writeSigned(long long number) {
+    separate();
+    char digits[24];
+    auto result = std::to_chars(digits, digits + sizeof(digits), number);
+    out.append(digits, result.ptr);
+    return *this;
+}
+
+JsonWriter& JsonWriter::writeUnsigned(unsigned long long number) {
+    separate();
+    char digits[24];
+    auto result = std::to_chars(digits, digits + sizeof(digits), number);
+    out.append(digits, result.ptr);
+    return *this;
+}
+
+void JsonWriter::appendString(std::string& out, std::string_view text) {
+    static const char HEX[] = "0123456789abcdef";
+
+    out += '"';
+    size_t start = 0;
+    while (start < text.size()) {
+        size_t special = jsonScanSpecial(text.data(), start, text.size());
+        out.append(text.data() + start, special - start);
+        if (special == text.size()) break;
+
+        unsigned char c = static_cast<unsigned char>(text[special]);
+        switch (c) {
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\b': out += "\\b"; break;
+            case '\f': out += "\\f"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            default: {
+                const char escape[] = {'\\', 'u', '0', '0', HEX[c >> 4], HEX[c & 0xF]};
+                out.append(escape, sizeof(escape));
+            }
+        }
+        start = special + 1;
+    }
+    out += '"';
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+// Appends JSON to a caller-owned buffer, so a buffer reserved once (or
+// reused across chunks) is written without further allocations.
+//
+// Commas are placed automatically: call key() then one value per member,
+// or just values inside an array. Strings are escaped; the plain runs
+// between characters that need escaping are copied in one go (see
+// jsonScanSpecial). Numbers go through std::to_chars, with no locale and
+// no iostreams.
+class JsonWriter {
+public:
+    explicit JsonWriter(std::string& buffer) : out(buffer) {}
+
+    JsonWriter& beginObject() { return open('{'); }
+    JsonWriter& endObject() { return close('}'); }
+    JsonWriter& beginArray() { return open('['); }
+    JsonWriter& endArray() { return close(']'); }
+
+    JsonWriter& key(std::string_view name);
+
+    JsonWriter& value(std::string_view text);
+    JsonWriter& value(const char* text) { return value(std::string_view(text)); }
+    JsonWriter& value(const std::string& text) { return value(std::string_view(text)); }
+    JsonWriter& value(bool flag);
+    JsonWriter& value(double number); // NaN and infinities are written as null
+    template <typename T, typename = std::enable_if_t<std::is_integral_v<T> && !std::is_same_v<T, bool>>>
+    JsonWriter& value(T number) {
+        if constexpr (std::is_signed_v<T>) return writeSigned(number);
+        else return writeUnsigned(number);
+    }
+    JsonWriter& null();
+
+    // key(name).value(v) in one call
+    template <typename T>
+    JsonWriter& field(std::string_view name, const T& v) { return key(name).value(v); }
+
+    // Appends text as a quoted, escaped JSON string
+    static void appendString(std::string& out, std::string_view text);
+
+private:
+    static constexpr int MAX_DEPTH = 64;
+
+    JsonWriter& open(char bracket);
+    JsonWriter& close(char bracket);
+    void separate();
+    JsonWriter& writeSigned(long long number);
+    JsonWriter& writeUnsigned(unsigned long long number);
+
+    std::string& out;
+    uint64_t hasItems = 0; // Bit d: the container at depth d already has an element
+    int depth = 0;
+    bool afterKey = false;
+};
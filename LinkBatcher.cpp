@@ -0,0 +1,98 @@
+#include "LinkBatcher.h"
+
+#include <algorithm>
+#include <iostream>
+
+using std::cerr;
+using std::endl;
+using std::lock_guard;
+using std::mutex;
+using std::unique_lock;
+
+LinkBatcher::LinkBatcher(UrlShortenerDB& db_instance, std::chrono::milliseconds batchWindow, size_t rowLimit)
+    : db(db_instance), window(batchWindow), maxRows(rowLimit == 0 ? 1 : rowLimit) {
+    committer = std::thread(&LinkBatcher::run, this);
+}
+
+LinkBatcher::~LinkBatcher() {
+    stop();
+}
+
+bool LinkBatcher::createLink(const ShortenedLink& link) {
+    Pending pending{&link, {}};
+    std::future<bool> created = pending.created.get_future();
+    bool wake;
+    {
+        lock_guard<mutex> lock(wakeMutex);
+        if (stopping) {
+            // Shutting down: no committer to wait for
+            return db.createLink(link);
+        }
+        if (queue.empty()) windowStart = std::chrono::steady_clock::now();
+        queue.push_back(&pending);
+        // The committer needs waking for the first row of a window and for a full batch
+        wake = queue.size() == 1 || queue.size() == maxRows;
+    }
+    if (wake) wakeCv.notify_one();
+    return created.get();
+}
+
+void LinkBatcher::stop() {
+    {
+        lock_guard<mutex> lock(wakeMutex);
+        if (stopping) return;
+        stopping = true;
+    }
+    wakeCv.notify_one();
+    if (committer.joinable()) committer.join();
+}
+
+void LinkBatcher::run() {
+    unique_lock<mutex> lock(wakeMutex);
+    for (;;) {
+        wakeCv.wait(lock, [this] { return stopping || !queue.empty(); });
+        if (queue.empty()) break; // Stopping and fully drained
+
+        // Let the batch fill up for the rest of its window
+        wakeCv.wait_until(lock, windowStart + window, [this] { return stopping || queue.size() >= maxRows; });
+
+        std::vector<Pending*> batch;
+        size_t take = std::min(queue.size(), maxRows);
+        batch.assign(queue.begin(), queue.begin() + take);
+        queue.erase(queue.begin(), queue.begin() + take);
+        // Rows left over start the next window now
+        if (!queue.empty()) windowStart = std::chrono::steady_clock::now();
+
+        lock.unlock();
+        commit(batch);
+        lock.lock();
+    }
+}
+
+void LinkBatcher::commit(std::vector<Pending*>& batch) {
+    std::vector<const ShortenedLink*> links;
+    links.reserve(batch.size());
+    for (Pending* pending : batch) links.push_back(pending->link);
+
+    std::vector<LinkInsertResult> results;
+    bool committed = db.createLinks(links, results);
+    batchCount.fetch_add(1, std::memory_order_relaxed);
+    rowCount.fetch_add(batch.size(), std::memory_order_relaxed);
+
+    if (!committed) {
+        // Nothing was written: isolate the bad row by inserting one by one
+        cerr << "DB_WARN: Group commit of " << batch.size() << " links failed, inserting them individually." << endl;
+        fallbackCount.fetch_add(1, std::memory_order_relaxed);
+        for (Pending* pending : batch) {
+            pending->created.set_value(db.createLink(*pending->link));
+        }
+        return;
+    }
+
+    for (size_t i = 0; i < batch.size(); ++i) {
+        if (results[i] == LinkInsertResult::Duplicate) {
+            duplicateCount.fetch_add(1, std::memory_order_relaxed);
+        }
+        batch[i]->created.set_value(results[i] == LinkInsertResult::Created);
+    }
+}
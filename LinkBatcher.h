@@ -0,0 +1,67 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "URLShortnerDB.h"
+
+// Group commit for link creation.
+//
+// createLink() queues the row and blocks until it is committed. A committer
+// thread collects rows for up to `window` after the first one arrives (or
+// until maxRows are queued) and writes them with UrlShortenerDB::createLinks:
+// one transaction and one multi-row INSERT, so a burst pays for one log
+// flush instead of one per link. Each caller gets its own row's result. If
+// the batch transaction fails as a whole, its rows are retried one by one,
+// so one bad row does not fail its neighbours.
+class LinkBatcher {
+public:
+    LinkBatcher(UrlShortenerDB& db, std::chrono::milliseconds window, size_t maxRows);
+    ~LinkBatcher();
+
+    LinkBatcher(const LinkBatcher&) = delete;
+    LinkBatcher& operator=(const LinkBatcher&) = delete;
+
+    // Same contract as UrlShortenerDB::createLink: false on duplicate code or DB error
+    bool createLink(const ShortenedLink& link);
+
+    // Commits what is queued and stops the committer; later calls insert directly
+    void stop();
+
+    unsigned long long batches() const { return batchCount.load(std::memory_order_relaxed); }
+    unsigned long long rows() const { return rowCount.load(std::memory_order_relaxed); }
+    unsigned long long duplicates() const { return duplicateCount.load(std::memory_order_relaxed); }
+    unsigned long long fallbacks() const { return fallbackCount.load(std::memory_order_relaxed); }
+
+private:
+    struct Pending {
+        const ShortenedLink* link; // Owned by the blocked caller
+        std::promise<bool> created;
+    };
+
+    void run();
+    void commit(std::vector<Pending*>& batch);
+
+    UrlShortenerDB& db;
+    std::chrono::milliseconds window;
+    size_t maxRows;
+
+    std::deque<Pending*> queue; // Guarded by wakeMutex
+    std::chrono::steady_clock::time_point windowStart;
+
+    std::atomic<unsigned long long> batchCount{0};
+    std::atomic<unsigned long long> rowCount{0};
+    std::atomic<unsigned long long> duplicateCount{0};
+    std::atomic<unsigned long long> fallbackCount{0};
+
+    std::mutex wakeMutex;
+    std::condition_variable wakeCv;
+    bool stopping = false;
+    std::thread committer;
+};
@@ -0,0 +1,95 @@
+#include "LinkCache.h"
+
+#include <functional>
+
+using std::lock_guard;
+using std::mutex;
+using std::shared_ptr;
+using std::string;
+
+LinkCache::LinkCache(size_t capacity, std::time_t maxAgeSeconds, size_t shardCount) : maxAge(maxAgeSeconds) {
+    if (shardCount == 0) shardCount = 1;
+    shards.reserve(shardCount);
+    for (size_t i = 0; i < shardCount; ++i) {
+        shards.push_back(std::make_unique<Shard>());
+    }
+    // Round up so the total never drops below the requested capacity
+    shardCapacity = (capacity + shardCount - 1) / shardCount;
+    if (shardCapacity == 0) shardCapacity = 1;
+}
+
+LinkCache::Shard& LinkCache::shardFor(const string& code) {
+    return *shards[std::hash<string>{}(code) % shards.size()];
+}
+
+shared_ptr<const CachedLink> LinkCache::get(const string& code) {
+    Shard& shard = shardFor(code);
+    lock_guard<mutex> lock(shard.mutex);
+
+    auto it = shard.index.find(code);
+    if (it == shard.index.end()) {
+        missCount.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+
+    // Link Expiration (or max age): drop the entry as soon as it is due
+    std::time_t evictAt = it->second->evictAt;
+    if (evictAt != 0 && evictAt <= std::time(nullptr)) {
+        shard.lru.erase(it->second);
+        shard.index.erase(it);
+        missCount.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+
+    shard.lru.splice(shard.lru.begin(), shard.lru, it->second);
+    hitCount.fetch_add(1, std::memory_order_relaxed);
+    return it->second->link;
+}
+
+void LinkCache::put(const string& code, CachedLink link) {
+    std::time_t evictAt = link.expires_epoch;
+    if (maxAge > 0) {
+        std::time_t capped = std::time(nullptr) + maxAge;
+        if (evictAt == 0 || capped < evictAt) evictAt = capped;
+    }
+    auto value = std::make_shared<const CachedLink>(std::move(link));
+    Shard& shard = shardFor(code);
+    lock_guard<mutex> lock(shard.mutex);
+
+    auto it = shard.index.find(code);
+    if (it != shard.index.end()) {
+        it->second->link = std::move(value);
+        it->second->evictAt = evictAt;
+        shard.lru.splice(shard.lru.begin(), shard.lru, it->second);
+        return;
+    }
+
+    shard.lru.push_front(Entry{code, std::move(value), evictAt});
+    shard.index.emplace(code, shard.lru.begin());
+
+    // Evict the least recently used entry once the shard is full
+    if (shard.lru.size() > shardCapacity) {
+        shard.index.erase(shard.lru.back().code);
+        shard.lru.pop_back();
+    }
+}
+
+void LinkCache::invalidate(const string& code) {
+    Shard& shard = shardFor(code);
+    lock_guard<mutex> lock(shard.mutex);
+
+    auto it = shard.index.find(code);
+    if (it != shard.index.end()) {
+        shard.lru.erase(it->second);
+        shard.index.erase(it);
+    }
+}
+
+size_t LinkCache::size() const {
+    size_t total = 0;
+    for (const auto& shard : shards) {
+        lock_guard<mutex> lock(shard->mutex);
+        total += shard->lru.size();
+    }
+    return total;
+}
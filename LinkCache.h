@@ -0,0 +1,61 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <ctime>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Resolved short link as kept by the redirect cache
+struct CachedLink {
+    unsigned int id = 0;
+    std::string original_url;
+    unsigned int user_id = 0;       // 0 when created by a guest
+    std::string expires_at;         // Same text as the DB column (YYYY-MM-DD HH:MM:SS)
+    std::time_t expires_epoch = 0;  // 0 = never expires
+};
+
+// Bounded, sharded LRU cache of short_code -> resolved link.
+// Each shard has its own lock so concurrent redirects for different codes
+// rarely contend. Entries are dropped lazily once the link expires or after
+// maxAge seconds (0 = no cap), whichever comes first, so a link deleted on
+// another instance stops redirecting here eventually.
+class LinkCache {
+public:
+    explicit LinkCache(size_t capacity, std::time_t maxAge = 0, size_t shardCount = 16);
+
+    // Returns the cached link, or nullptr on a miss / expired entry
+    std::shared_ptr<const CachedLink> get(const std::string& code);
+    void put(const std::string& code, CachedLink link);
+    void invalidate(const std::string& code);
+
+    size_t capacity() const { return shardCapacity * shards.size(); }
+    size_t size() const;
+    unsigned long long hits() const { return hitCount.load(std::memory_order_relaxed); }
+    unsigned long long misses() const { return missCount.load(std::memory_order_relaxed); }
+
+private:
+    struct Entry {
+        std::string code;
+        std::shared_ptr<const CachedLink> link;
+        std::time_t evictAt; // 0 = only by LRU
+    };
+
+    struct Shard {
+        mutable std::mutex mutex;
+        std::list<Entry> lru; // front = most recently used
+        std::unordered_map<std::string, std::list<Entry>::iterator> index;
+    };
+
+    Shard& shardFor(const std::string& code);
+
+    std::vector<std::unique_ptr<Shard>> shards;
+    size_t shardCapacity;
+    std::time_t maxAge;
+    std::atomic<unsigned long long> hitCount{0};
+    std::atomic<unsigned long long> missCount{0};
+};
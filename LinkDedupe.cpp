@@ -0,0 +1,139 @@
+#include "LinkDedupe.h"
+
+#include <algorithm>
+
+namespace {
+// splitmix64 finalizer, spreads FNV's weak low bits
+uint64_t mix(uint64_t hash) {
+    hash ^= hash >> 30;
+    hash *= 0xbf58476d1ce4e5b9ULL;
+    hash ^= hash >> 27;
+    hash *= 0x94d049bb133111ebULL;
+    hash ^= hash >> 31;
+    return hash;
+}
+
+uint64_t fnv1a(std::string_view text, uint64_t hash = 1469598103934665603ULL) {
+    for (unsigned char c : text) {
+        hash ^= c;
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+}
+
+LinkDedupeIndex::LinkDedupeIndex(size_t capacity, size_t shardCount)
+    : shardCapacity(std::max<size_t>(1, capacity / std::max<size_t>(1, shardCount))) {
+    shards.reserve(std::max<size_t>(1, shardCount));
+    for (size_t i = 0; i < std::max<size_t>(1, shardCount); ++i) {
+        shards.push_back(std::make_unique<Shard>());
+    }
+}
+
+uint64_t LinkDedupeIndex::hashUrl(std::string_view canonicalUrl) {
+    return mix(fnv1a(canonicalUrl));
+}
+
+uint64_t LinkDedupeIndex::keyFor(unsigned int userId, std::string_view guestIdentifier, uint64_t urlHash) {
+    // 'u'/'g' keep user 42 and guest "42" apart
+    uint64_t owner = userId != 0 ? fnv1a(std::to_string(userId), fnv1a("u")) : fnv1a(guestIdentifier, fnv1a("g"));
+    return mix(urlHash ^ mix(owner));
+}
+
+LinkDedupeIndex::KeyLock LinkDedupeIndex::lock(uint64_t key) {
+    std::unique_lock<std::mutex> guard(inFlightMutex);
+    InFlight& slot = inFlight[key]; // Map nodes stay put while others are inserted or erased
+    ++slot.waiters;
+    slot.released.wait(guard, [&slot] { return !slot.held; });
+    --slot.waiters;
+    slot.held = true;
+    return KeyLock(this, key);
+}
+
+void LinkDedupeIndex::release(uint64_t key) {
+    std::lock_guard<std::mutex> guard(inFlightMutex);
+    auto it = inFlight.find(key);
+    if (it == inFlight.end()) return;
+    if (it->second.waiters == 0) {
+        inFlight.erase(it);
+        return;
+    }
+    it->second.held = false;
+    it->second.released.notify_one();
+}
+
+LinkDedupeIndex::KeyLock::KeyLock(KeyLock&& other) noexcept : index(other.index), key(other.key) {
+    other.index = nullptr;
+}
+
+LinkDedupeIndex::KeyLock& LinkDedupeIndex::KeyLock::operator=(KeyLock&& other) noexcept {
+    if (this != &other) {
+        unlock();
+        index = other.index;
+        key = other.key;
+        other.index = nullptr;
+    }
+    return *this;
+}
+
+void LinkDedupeIndex::KeyLock::unlock() {
+    if (index) index->release(key);
+    index = nullptr;
+}
+
+bool LinkDedupeIndex::find(uint64_t key, Entry& entry) {
+    Shard& shard = shardFor(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.entries.find(key);
+    if (it == shard.entries.end()) {
+        missCount.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    if (it->second.expiresEpoch != 0 && it->second.expiresEpoch <= std::time(nullptr)) {
+        shard.entries.erase(it);
+        missCount.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    entry = it->second;
+    hitCount.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+void LinkDedupeIndex::remember(uint64_t key, const std::string& code, std::time_t expiresEpoch) {
+    Shard& shard = shardFor(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto inserted = shard.entries.try_emplace(key);
+    inserted.first->second.code = code;
+    inserted.first->second.expiresEpoch = expiresEpoch;
+    if (!inserted.second) return;
+
+    shard.order.push_back(key);
+    // Keys forgotten earlier may still sit in order; erasing them again is a no-op
+    while (shard.entries.size() > shardCapacity && !shard.order.empty()) {
+        shard.entries.erase(shard.order.front());
+        shard.order.pop_front();
+    }
+    if (shard.order.size() > 2 * shardCapacity) {
+        // Drop stale keys left behind by forget()
+        std::deque<uint64_t> live;
+        for (uint64_t k : shard.order) {
+            if (shard.entries.count(k)) live.push_back(k);
+        }
+        shard.order.swap(live);
+    }
+}
+
+void LinkDedupeIndex::forget(uint64_t key) {
+    Shard& shard = shardFor(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    shard.entries.erase(key);
+}
+
+size_t LinkDedupeIndex::size() const {
+    size_t total = 0;
+    for (const auto& shard : shards) {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        total += shard->entries.size();
+    }
+    return total;
+}
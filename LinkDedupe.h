@@ -0,0 +1,93 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <ctime>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Owner-scoped long URL -> short code index for DEDUPE_LINKS.
+//
+// Keys combine the owner (user id or guest identifier) with the 64-bit hash
+// of the canonical URL, so one owner's link is never handed to another.
+// Entries are hints only: a hit must still be confirmed against the link,
+// which may have been deleted since. A miss falls back to the url_hash
+// index in shortened_links. Each shard is bounded, and the oldest entries
+// are evicted first.
+//
+// lock() marks the exact key as in flight. Identical shortens running at the
+// same time therefore do their lookup-or-insert one after another and all end
+// up with the same code, while requests for any other key never wait on them.
+class LinkDedupeIndex {
+public:
+    struct Entry {
+        std::string code;
+        std::time_t expiresEpoch = 0; // 0 = never expires
+    };
+
+    explicit LinkDedupeIndex(size_t capacity, size_t shardCount = 16);
+
+    // Stored in shortened_links.url_hash; must stay stable across releases
+    static uint64_t hashUrl(std::string_view canonicalUrl);
+    // userId 0 means a guest link owned by guestIdentifier
+    static uint64_t keyFor(unsigned int userId, std::string_view guestIdentifier, uint64_t urlHash);
+
+    // Held by the one request looking up or creating the link for a key; movable, released on destruction
+    class KeyLock {
+    public:
+        KeyLock() = default;
+        KeyLock(KeyLock&& other) noexcept;
+        KeyLock& operator=(KeyLock&& other) noexcept;
+        ~KeyLock() { unlock(); }
+
+        void unlock();
+
+    private:
+        friend class LinkDedupeIndex;
+        KeyLock(LinkDedupeIndex* owner, uint64_t key) : index(owner), key(key) {}
+
+        LinkDedupeIndex* index = nullptr;
+        uint64_t key = 0;
+    };
+
+    // Waits while another request holds the same key
+    KeyLock lock(uint64_t key);
+
+    bool find(uint64_t key, Entry& entry);
+    void remember(uint64_t key, const std::string& code, std::time_t expiresEpoch);
+    void forget(uint64_t key);
+
+    size_t capacity() const { return shardCapacity * shards.size(); }
+    size_t size() const;
+    unsigned long long hits() const { return hitCount.load(std::memory_order_relaxed); }
+    unsigned long long misses() const { return missCount.load(std::memory_order_relaxed); }
+
+private:
+    struct Shard {
+        mutable std::mutex mutex;
+        std::unordered_map<uint64_t, Entry> entries;
+        std::deque<uint64_t> order; // Insertion order, front is evicted first
+    };
+
+    struct InFlight {
+        std::condition_variable released;
+        size_t waiters = 0;
+        bool held = false;
+    };
+
+    Shard& shardFor(uint64_t key) { return *shards[key % shards.size()]; }
+    void release(uint64_t key);
+
+    std::vector<std::unique_ptr<Shard>> shards;
+    size_t shardCapacity;
+    std::mutex inFlightMutex;
+    std::unordered_map<uint64_t, InFlight> inFlight; // Held keys, dropped once nobody waits
+    std::atomic<unsigned long long> hitCount{0};
+    std::atomic<unsigned long long> missCount{0};
+};
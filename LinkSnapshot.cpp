@@ -0,0 +1,319 @@
+#include "LinkSnapshot.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using std::cerr;
+using std::endl;
+using std::string;
+
+namespace {
+
+const char SNAPSHOT_MAGIC[8] = {'U', 'R', 'L', 'S', 'N', 'A', 'P', '1'};
+const uint32_t SNAPSHOT_VERSION = 1;
+const size_t HEADER_SIZE = 64;
+const size_t RECORD_FIXED_SIZE = 4 + 4 + 8 + 2 + 4; // id, user_id, expires, code len, url len
+const uint32_t DIRECT_SLOT_FLAG = 0x80000000u;      // Seed stores the slot itself (singleton buckets)
+const uint32_t MAX_SEED = 1u << 24;
+const size_t KEYS_PER_BUCKET = 4;
+
+// Stable across builds and platforms: the file format depends on it
+uint64_t snapshotHash(const char* data, size_t length, uint32_t seed) {
+    uint64_t hash = 1469598103934665603ULL ^ (static_cast<uint64_t>(seed) * 0x9E3779B97F4A7C15ULL);
+    for (size_t i = 0; i < length; ++i) {
+        hash ^= static_cast<unsigned char>(data[i]);
+        hash *= 1099511628211ULL;
+    }
+    hash ^= hash >> 30;
+    hash *= 0xbf58476d1ce4e5b9ULL;
+    hash ^= hash >> 27;
+    hash *= 0x94d049bb133111ebULL;
+    hash ^= hash >> 31;
+    return hash;
+}
+
+void putU16(string& out, uint16_t value) {
+    for (int i = 0; i < 2; ++i) out.push_back(static_cast<char>(value >> (8 * i)));
+}
+
+void putU32(string& out, uint32_t value) {
+    for (int i = 0; i < 4; ++i) out.push_back(static_cast<char>(value >> (8 * i)));
+}
+
+void putU64(string& out, uint64_t value) {
+    for (int i = 0; i < 8; ++i) out.push_back(static_cast<char>(value >> (8 * i)));
+}
+
+uint16_t getU16(const unsigned char* p) {
+    return static_cast<uint16_t>(p[0] | (p[1] << 8));
+}
+
+uint32_t getU32(const unsigned char* p) {
+    uint32_t value = 0;
+    for (int i = 3; i >= 0; --i) value = (value << 8) | p[i];
+    return value;
+}
+
+uint64_t getU64(const unsigned char* p) {
+    uint64_t value = 0;
+    for (int i = 7; i >= 0; --i) value = (value << 8) | p[i];
+    return value;
+}
+
+} // namespace
+
+// --- LinkSnapshot (reader) ---
+
+LinkSnapshot::~LinkSnapshot() {
+    close();
+}
+
+void LinkSnapshot::close() {
+    if (base) {
+        munmap(const_cast<unsigned char*>(base), mappedSize);
+        base = nullptr;
+    }
+}
+
+bool LinkSnapshot::open(const string& path) {
+    close();
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        cerr << "SNAPSHOT_ERROR: Cannot open " << path << endl;
+        return false;
+    }
+
+    struct stat st = {};
+    if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < HEADER_SIZE) {
+        cerr << "SNAPSHOT_ERROR: " << path << " is too small to be a link snapshot." << endl;
+        ::close(fd);
+        return false;
+    }
+
+    size_t size = static_cast<size_t>(st.st_size);
+    void* mapped = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd); // The mapping stays valid after the descriptor is closed
+    if (mapped == MAP_FAILED) {
+        cerr << "SNAPSHOT_ERROR: mmap failed for " << path << endl;
+        return false;
+    }
+    madvise(mapped, size, MADV_RANDOM); // Lookups hit scattered pages
+
+    const unsigned char* data = static_cast<const unsigned char*>(mapped);
+    uint32_t version = getU32(data + 8);
+    uint32_t buckets = getU32(data + 12);
+    uint64_t count = getU64(data + 16);
+    uint64_t createdAt = getU64(data + 24);
+    uint64_t seedsOffset = getU64(data + 32);
+    uint64_t slotsOffset = getU64(data + 40);
+    uint64_t recordsOffset = getU64(data + 48);
+
+    bool valid = std::memcmp(data, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) == 0 &&
+                 version == SNAPSHOT_VERSION && buckets > 0 &&
+                 seedsOffset + 4ULL * buckets <= size &&
+                 slotsOffset + 8ULL * count <= size &&
+                 recordsOffset <= size;
+    if (!valid) {
+        cerr << "SNAPSHOT_ERROR: " << path << " is not a valid link snapshot (version " << version << ")." << endl;
+        munmap(mapped, size);
+        return false;
+    }
+
+    base = data;
+    mappedSize = size;
+    bucketCount = buckets;
+    recordCount = count;
+    created = static_cast<std::time_t>(createdAt);
+    seeds = data + seedsOffset;
+    slots = data + slotsOffset;
+    records = data + recordsOffset;
+    recordsSize = size - recordsOffset;
+    return true;
+}
+
+bool LinkSnapshot::lookup(const string& code, SnapshotLink& out) const {
+    if (!base || recordCount == 0) return false;
+
+    uint32_t bucket = static_cast<uint32_t>(snapshotHash(code.data(), code.size(), 0) % bucketCount);
+    uint32_t seed = getU32(seeds + 4ULL * bucket);
+    uint64_t slot = (seed & DIRECT_SLOT_FLAG)
+        ? (seed & ~DIRECT_SLOT_FLAG)
+        : snapshotHash(code.data(), code.size(), seed) % recordCount;
+    if (slot >= recordCount) return false;
+
+    uint64_t offset = getU64(slots + 8ULL * slot);
+    if (offset + RECORD_FIXED_SIZE > recordsSize) return false;
+
+    const unsigned char* record = records + offset;
+    uint16_t codeLength = getU16(record + 16);
+    uint32_t urlLength = getU32(record + 18);
+    if (offset + RECORD_FIXED_SIZE + codeLength + urlLength > recordsSize) return false;
+
+    // The perfect hash maps unknown keys to some slot too: verify the key
+    const char* storedCode = reinterpret_cast<const char*>(record + RECORD_FIXED_SIZE);
+    if (codeLength != code.size() || std::memcmp(storedCode, code.data(), codeLength) != 0) {
+        return false;
+    }
+
+    // Link Expiration
+    std::time_t expires = static_cast<std::time_t>(getU64(record + 8));
+    if (expires != 0 && expires <= std::time(nullptr)) return false;
+
+    out.id = getU32(record);
+    out.user_id = getU32(record + 4);
+    out.expires_epoch = expires;
+    out.short_code = code;
+    out.original_url.assign(storedCode + codeLength, urlLength);
+    return true;
+}
+
+// --- LinkSnapshotWriter ---
+
+void LinkSnapshotWriter::add(SnapshotLink link) {
+    links.push_back(std::move(link));
+}
+
+bool LinkSnapshotWriter::write(const string& path) {
+    // short_code is UNIQUE in the DB; dedupe anyway since the hash needs distinct keys
+    std::sort(links.begin(), links.end(), [](const SnapshotLink& a, const SnapshotLink& b) {
+        return a.short_code < b.short_code;
+    });
+    links.erase(std::unique(links.begin(), links.end(), [](const SnapshotLink& a, const SnapshotLink& b) {
+        return a.short_code == b.short_code;
+    }), links.end());
+
+    const uint64_t count = links.size();
+    if (count >= DIRECT_SLOT_FLAG) {
+        cerr << "SNAPSHOT_ERROR: Too many links for one snapshot file." << endl;
+        return false;
+    }
+    const uint32_t buckets = static_cast<uint32_t>(std::max<uint64_t>(1, count / KEYS_PER_BUCKET));
+
+    // --- Build the minimal perfect hash (hash-and-displace) ---
+    std::vector<std::vector<uint32_t>> bucketKeys(buckets);
+    for (uint32_t i = 0; i < count; ++i) {
+        const string& code = links[i].short_code;
+        bucketKeys[snapshotHash(code.data(), code.size(), 0) % buckets].push_back(i);
+    }
+
+    // Place the largest buckets first while most slots are still free
+    std::vector<uint32_t> order(buckets);
+    for (uint32_t b = 0; b < buckets; ++b) order[b] = b;
+    std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+        return bucketKeys[a].size() > bucketKeys[b].size();
+    });
+
+    std::vector<uint32_t> seeds(buckets, 0);
+    std::vector<int64_t> slotToLink(count, -1);
+    std::vector<uint64_t> candidate;
+    uint64_t nextFreeSlot = 0;
+
+    for (uint32_t bucket : order) {
+        const auto& keys = bucketKeys[bucket];
+        if (keys.empty()) break; // Sorted by size, so all remaining buckets are empty
+
+        if (keys.size() == 1) {
+            // Singletons go straight into any free slot, stored directly in the seed
+            while (slotToLink[nextFreeSlot] != -1) ++nextFreeSlot;
+            slotToLink[nextFreeSlot] = keys[0];
+            seeds[bucket] = DIRECT_SLOT_FLAG | static_cast<uint32_t>(nextFreeSlot);
+            continue;
+        }
+
+        bool placed = false;
+        for (uint32_t seed = 1; seed < MAX_SEED && !placed; ++seed) {
+            candidate.clear();
+            bool ok = true;
+            for (uint32_t key : keys) {
+                const string& code = links[key].short_code;
+                uint64_t slot = snapshotHash(code.data(), code.size(), seed) % count;
+                if (slotToLink[slot] != -1 || std::find(candidate.begin(), candidate.end(), slot) != candidate.end()) {
+                    ok = false;
+                    break;
+                }
+                candidate.push_back(slot);
+            }
+            if (!ok) continue;
+
+            for (size_t i = 0; i < keys.size(); ++i) {
+                slotToLink[candidate[i]] = keys[i];
+            }
+            seeds[bucket] = seed;
+            placed = true;
+        }
+
+        if (!placed) {
+            cerr << "SNAPSHOT_ERROR: Could not build the perfect hash (bucket of " << keys.size() << " keys)." << endl;
+            return false;
+        }
+    }
+
+    // --- Serialize records and remember their offsets ---
+    string recordData;
+    std::vector<uint64_t> recordOffsets(count);
+    for (uint64_t i = 0; i < count; ++i) {
+        const SnapshotLink& link = links[i];
+        if (link.short_code.size() > 0xffff || link.original_url.size() > 0xffffffffULL) {
+            cerr << "SNAPSHOT_ERROR: Link " << link.id << " is too large for the snapshot format." << endl;
+            return false;
+        }
+        recordOffsets[i] = recordData.size();
+        putU32(recordData, link.id);
+        putU32(recordData, link.user_id);
+        putU64(recordData, static_cast<uint64_t>(link.expires_epoch));
+        putU16(recordData, static_cast<uint16_t>(link.short_code.size()));
+        putU32(recordData, static_cast<uint32_t>(link.original_url.size()));
+        recordData += link.short_code;
+        recordData += link.original_url;
+    }
+
+    const uint64_t seedsOffset = HEADER_SIZE;
+    const uint64_t slotsOffset = seedsOffset + 4ULL * buckets;
+    const uint64_t recordsOffset = slotsOffset + 8ULL * count;
+
+    string header(SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+    putU32(header, SNAPSHOT_VERSION);
+    putU32(header, buckets);
+    putU64(header, count);
+    putU64(header, static_cast<uint64_t>(createdAt != 0 ? createdAt : std::time(nullptr)));
+    putU64(header, seedsOffset);
+    putU64(header, slotsOffset);
+    putU64(header, recordsOffset);
+    header.resize(HEADER_SIZE, '\0');
+
+    string index;
+    index.reserve(4ULL * buckets + 8ULL * count);
+    for (uint32_t seed : seeds) putU32(index, seed);
+    for (uint64_t slot = 0; slot < count; ++slot) putU64(index, recordOffsets[slotToLink[slot]]);
+
+    // Write to a temp file and rename, so running servers never map a partial file
+    const string tempPath = path + ".tmp";
+    {
+        std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+        if (!file) {
+            cerr << "SNAPSHOT_ERROR: Cannot write " << tempPath << endl;
+            return false;
+        }
+        file.write(header.data(), header.size());
+        file.write(index.data(), index.size());
+        file.write(recordData.data(), recordData.size());
+        if (!file) {
+            cerr << "SNAPSHOT_ERROR: Write failed for " << tempPath << endl;
+            return false;
+        }
+    }
+    if (std::rename(tempPath.c_str(), path.c_str()) != 0) {
+        cerr << "SNAPSHOT_ERROR: Cannot move " << tempPath << " to " << path << endl;
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstdint>
+#include <ctime>
+#include <string>
+#include <vector>
+
+// Immutable, memory-mapped snapshot of shortened_links for DB-free redirects.
+//
+// File layout (all integers little-endian, produced by LinkSnapshotWriter):
+//
+//   Header        magic "URLSNAP1", version, bucket/record counts, section offsets
+//   Seeds         uint32[bucketCount]  displacement per bucket of the perfect hash
+//   Slots         uint64[recordCount]  record offset for each hash slot
+//   Records       id, user_id, expires_epoch, code length, url length, code, url
+//
+// The index is a minimal perfect hash (hash-and-displace): a key's bucket
+// selects a seed and the seed selects one of exactly recordCount slots, so a
+// lookup is two hashes, two array reads and one key comparison. The file is
+// mapped read-only and shared, so worker processes share its pages.
+struct SnapshotLink {
+    unsigned int id = 0;
+    unsigned int user_id = 0;       // 0 when created by a guest
+    std::time_t expires_epoch = 0;  // 0 = never expires
+    std::string short_code;
+    std::string original_url;
+};
+
+class LinkSnapshot {
+public:
+    LinkSnapshot() = default;
+    ~LinkSnapshot();
+
+    LinkSnapshot(const LinkSnapshot&) = delete;
+    LinkSnapshot& operator=(const LinkSnapshot&) = delete;
+
+    // Maps and validates the file; returns false (and logs) on any error
+    bool open(const std::string& path);
+    bool isOpen() const { return base != nullptr; }
+
+    // Finds a non-expired link; fills `out` and returns true on a hit
+    bool lookup(const std::string& code, SnapshotLink& out) const;
+
+    uint64_t size() const { return recordCount; }
+    std::time_t createdAt() const { return created; }
+
+private:
+    void close();
+
+    const unsigned char* base = nullptr;
+    size_t mappedSize = 0;
+    uint32_t bucketCount = 0;
+    uint64_t recordCount = 0;
+    std::time_t created = 0;
+    const unsigned char* seeds = nullptr;
+    const unsigned char* slots = nullptr;
+    const unsigned char* records = nullptr;
+    size_t recordsSize = 0;
+};
+
+// Builds a snapshot file from links streamed out of the database
+class LinkSnapshotWriter {
+public:
+    void add(SnapshotLink link);
+    // Recorded as the build time; set it before streaming so deletions made meanwhile count as later
+    void setCreatedAt(std::time_t epoch) { createdAt = epoch; }
+
+    // Builds the perfect hash and writes the file atomically (temp + rename)
+    bool write(const std::string& path);
+
+    size_t size() const { return links.size(); }
+
+private:
+    std::vector<SnapshotLink> links;
+    std::time_t createdAt = 0; // 0 = when write() runs
+};
@@ -0,0 +1,88 @@
+#include "LinkTombstones.h"
+#include "URLShortnerDB.h"
+
+#include <iostream>
+#include <utility>
+#include <vector>
+
+using std::cerr;
+using std::endl;
+using std::lock_guard;
+using std::mutex;
+using std::string;
+using std::unique_lock;
+
+LinkTombstones::LinkTombstones(UrlShortenerDB& db_instance, std::chrono::seconds interval)
+    : db(db_instance), syncInterval(interval) {
+}
+
+LinkTombstones::~LinkTombstones() {
+    stop();
+}
+
+bool LinkTombstones::start(std::time_t sinceEpoch) {
+    since = sinceEpoch;
+    if (!sync()) return false;
+    if (syncInterval.count() > 0) {
+        syncer = std::thread(&LinkTombstones::run, this);
+    }
+    return true;
+}
+
+bool LinkTombstones::sync() {
+    lock_guard<mutex> syncLock(syncMutex);
+
+    uint64_t after = highest > ID_OVERLAP ? highest - ID_OVERLAP : 0;
+    std::vector<std::pair<uint64_t, string>> rows;
+    bool ok = db.forEachDeletedCode(after, since, [&rows](uint64_t id, const string& code) {
+        rows.emplace_back(id, code);
+    });
+    if (!ok) {
+        cerr << "DB_WARN: Could not sync link snapshot tombstones, keeping the previous set." << endl;
+        return false;
+    }
+
+    std::unique_lock<std::shared_mutex> lock(setMutex);
+    for (auto& row : rows) {
+        if (row.first > highest) highest = row.first;
+        codes.insert(std::move(row.second));
+    }
+    return true;
+}
+
+void LinkTombstones::add(const string& code) {
+    std::unique_lock<std::shared_mutex> lock(setMutex);
+    codes.insert(code);
+}
+
+bool LinkTombstones::contains(const string& code) const {
+    std::shared_lock<std::shared_mutex> lock(setMutex);
+    return codes.count(code) != 0;
+}
+
+size_t LinkTombstones::size() const {
+    std::shared_lock<std::shared_mutex> lock(setMutex);
+    return codes.size();
+}
+
+void LinkTombstones::run() {
+    unique_lock<mutex> lock(wakeMutex);
+    while (!stopping) {
+        wakeCv.wait_for(lock, syncInterval, [this] { return stopping; });
+        if (stopping) break;
+
+        lock.unlock();
+        sync();
+        lock.lock();
+    }
+}
+
+void LinkTombstones::stop() {
+    {
+        lock_guard<mutex> lock(wakeMutex);
+        if (stopping) return;
+        stopping = true;
+    }
+    wakeCv.notify_one();
+    if (syncer.joinable()) syncer.join();
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <ctime>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <unordered_set>
+
+class UrlShortenerDB;
+
+// Short codes deleted since the link snapshot was built, which it must no
+// longer serve.
+//
+// Every deleteLink() records the code in deleted_codes. start() loads the
+// rows deleted since `since` (the snapshot's build time minus a margin for
+// clock skew) and starts a thread that adds newer rows every syncInterval.
+// Deletions made by other processes or instances therefore stop being
+// served within one interval, and survive a restart. Deletions made here
+// are added immediately.
+class LinkTombstones {
+public:
+    LinkTombstones(UrlShortenerDB& db, std::chrono::seconds syncInterval);
+    ~LinkTombstones();
+
+    LinkTombstones(const LinkTombstones&) = delete;
+    LinkTombstones& operator=(const LinkTombstones&) = delete;
+
+    // Initial load; the snapshot must not be used when this fails
+    bool start(std::time_t since);
+    // Adds rows recorded since the last pass (also called by the background thread)
+    bool sync();
+    void add(const std::string& code);
+    bool contains(const std::string& code) const;
+    void stop();
+
+    size_t size() const;
+
+private:
+    // Ids are assigned at insert but visible at commit, so each pass re-reads a few
+    static constexpr uint64_t ID_OVERLAP = 1024;
+
+    void run();
+
+    UrlShortenerDB& db;
+    std::chrono::seconds syncInterval;
+    std::time_t since = 0;
+
+    mutable std::shared_mutex setMutex;
+    std::unordered_set<std::string> codes;
+    uint64_t highest = 0; // Highest deleted_codes.id seen
+
+    std::mutex syncMutex;
+    std::mutex wakeMutex;
+    std::condition_variable wakeCv;
+    bool stopping = false;
+    std::thread syncer;
+};
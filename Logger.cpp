@@ -1,10 +1,13 @@
 #include "Logger.h"
 #include <sentry.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
 #include <iostream>
-#include <sstream>
 #include <string>
-#include <ctime>
-#include <iomanip>
+
+#include <unistd.h>
 
 using namespace httplib;
 using namespace std;
@@ -13,64 +16,192 @@ using namespace std;
 const string CORS_HEADER_KEY = "Access-Control-Allow-Origin";
 const string CORS_HEADER_VALUE = "*";
 
-bool SaveLogs::log_request(const Request &req, Response &res) {
-    // 1. Prepare Request Details
-    string payload_summary;
-    string full_payload = (req.method == "POST" || req.method == "PUT") ? req.body : "[N/A]";
-    
-    if (full_payload != "[N/A]") {
-        const size_t max_len = 100;
-        payload_summary = (full_payload.size() < max_len) ? full_payload : full_payload.substr(0, max_len) + "...";
-    } else {
-        payload_summary = full_payload;
+namespace {
+
+const size_t BATCH_SIZE = 256;
+
+int64_t nowMicros() {
+    return chrono::duration_cast<chrono::microseconds>(chrono::system_clock::now().time_since_epoch()).count();
+}
+
+size_t copyField(char* dest, size_t capacity, const string& value) {
+    size_t length = min(value.size(), capacity);
+    memcpy(dest, value.data(), length);
+    return length;
+}
+
+void writeAll(const string& buffer) {
+    size_t offset = 0;
+    while (offset < buffer.size()) {
+        ssize_t written = ::write(STDERR_FILENO, buffer.data() + offset, buffer.size() - offset);
+        if (written <= 0) return; // Nothing sensible to do if stderr is gone
+        offset += static_cast<size_t>(written);
     }
+}
+
+} // namespace
 
-    // 2. Add CORS headers to response (required for React frontend)
+SaveLogs::SaveLogs(const Options& opts)
+    : options(opts), ring(opts.capacity) {
+    sentryTokens = options.sentryMaxPerSecond;
+    sentryLastRefill = nowMicros();
+    writer = thread(&SaveLogs::run, this);
+}
+
+SaveLogs::~SaveLogs() {
+    stop();
+}
+
+bool SaveLogs::log_request(const Request &req, Response &res) {
+    // 1. Add CORS headers to response (required for React frontend)
     res.set_header(CORS_HEADER_KEY, CORS_HEADER_VALUE);
     res.set_header("Access-Control-Allow-Methods", "GET, POST, OPTIONS");
     res.set_header("Access-Control-Allow-Headers", "Content-Type");
 
-    // 3. Log to Sentry (Structured Event)
+    // 2. Capture the request into a fixed record, no formatting on this thread
+    Record record;
+    record.timestampMicros = nowMicros();
+    copyField(record.method, sizeof(record.method), req.method);
+    copyField(record.ip, sizeof(record.ip) - 1, req.remote_addr);
+    record.pathLength = static_cast<uint16_t>(copyField(record.path, MAX_PATH, req.path));
+    if (req.method == "POST" || req.method == "PUT") {
+        record.hasPayload = true;
+        record.payloadLength = static_cast<uint16_t>(copyField(record.payload, MAX_PAYLOAD, req.body));
+        record.payloadTruncated = req.body.size() > MAX_PAYLOAD;
+    }
+
+    // 3. Hand off; a full ring means the writer is behind, so drop rather than block
+    if (!ring.tryPush(record)) {
+        droppedCount.fetch_add(1, memory_order_relaxed);
+        return false;
+    }
+    return true;
+}
+
+void SaveLogs::stop() {
     {
-        // Create a new Sentry Event
-        sentry_value_t event = sentry_value_new_message_event(
-            SENTRY_LEVEL_INFO, 
-            "http.request", 
-            ("Incoming Request: " + req.method + " " + req.path).c_str()
-        );
-
-        // --- Add Required Contextual Data as Tags (Searchable in Sentry UI) ---
-        // Sentry automatically handles date/time.
-        sentry_set_tag("app.file", "Logger.cpp");
-        sentry_set_tag("app.class", "SaveLogs");
-        sentry_set_tag("app.function", "log_request");
-        sentry_set_tag("http.ip", req.remote_addr.c_str());
-        sentry_set_tag("http.method", req.method.c_str());
-        sentry_set_tag("http.path", req.path.c_str());
-
-        // --- Add Payload as Extra Context ---
-        sentry_set_extra("request.payload_summary", sentry_value_new_string(payload_summary.c_str()));
-        sentry_set_extra("request.full_payload", sentry_value_new_string(full_payload.c_str()));
-
-
-        // Capture the event
-        sentry_capture_event(event);
+        lock_guard<mutex> lock(wakeMutex);
+        if (stopping) return;
+        stopping = true;
     }
-    
-    // 4. Log to console (Local output)
-    time_t now = time(nullptr);
-    tm *ltm = localtime(&now); 
-    stringstream time_ss;
-    if (ltm) {
-        time_ss << put_time(ltm, "%Y-%m-%d %H:%M:%S");
-    } else {
-        time_ss << "TIME_ERROR";
+    wakeCv.notify_one();
+    if (writer.joinable()) writer.join();
+}
+
+void SaveLogs::run() {
+    string buffer;
+    buffer.reserve(BATCH_SIZE * 256);
+
+    for (;;) {
+        while (drain(buffer) == BATCH_SIZE) {
+            // Keep going while the ring is busy
+        }
+
+        unique_lock<mutex> lock(wakeMutex);
+        if (stopping) break;
+        wakeCv.wait_for(lock, options.flushInterval, [this] { return stopping; });
+    }
+
+    // Final drain so nothing accepted before stop() is lost
+    while (drain(buffer) > 0) {
+    }
+}
+
+size_t SaveLogs::drain(string& buffer) {
+    buffer.clear();
+    Record record;
+    size_t count = 0;
+    while (count < BATCH_SIZE && ring.tryPop(record)) {
+        format(record, buffer);
+        if (options.sentryEnabled) sendToSentry(record);
+        ++count;
+    }
+
+    if (count > 0) {
+        unsigned long long droppedSoFar = droppedCount.load(memory_order_relaxed);
+        if (droppedSoFar > droppedReported) {
+            buffer += "LOG_WARN: " + to_string(droppedSoFar - droppedReported) + " request log records dropped (ring full)\n";
+            droppedReported = droppedSoFar;
+        }
+        writeAll(buffer);
+        writtenCount.fetch_add(count, memory_order_relaxed);
+    }
+    return count;
+}
+
+void SaveLogs::format(const Record& record, string& buffer) {
+    // Time is formatted once per second, not once per record
+    int64_t second = record.timestampMicros / 1000000;
+    if (second != cachedSecond) {
+        time_t now = static_cast<time_t>(second);
+        tm ltm;
+        if (localtime_r(&now, &ltm)) {
+            strftime(cachedTime, sizeof(cachedTime), "%Y-%m-%d %H:%M:%S", &ltm);
+        } else {
+            snprintf(cachedTime, sizeof(cachedTime), "TIME_ERROR");
+        }
+        cachedSecond = second;
     }
 
     // Log format requested: <date and time> <FileName> <class Name> <function name> <...other details> <Log message/stacktrace/etc.>
-    cerr << time_ss.str() << " | Logger.cpp | SaveLogs | log_request | " 
-         << "IP: " << req.remote_addr << ", Method: " << req.method << ", Path: " << req.path << " | "
-         << "Payload: " << payload_summary << endl;
+    buffer += cachedTime;
+    buffer += " | Logger.cpp | SaveLogs | log_request | IP: ";
+    buffer += record.ip;
+    buffer += ", Method: ";
+    buffer.append(record.method, strnlen(record.method, sizeof(record.method)));
+    buffer += ", Path: ";
+    buffer.append(record.path, record.pathLength);
+    buffer += " | Payload: ";
+    if (record.hasPayload) {
+        buffer.append(record.payload, record.payloadLength);
+        if (record.payloadTruncated) buffer += "...";
+    } else {
+        buffer += "[N/A]";
+    }
+    buffer += '\n';
+}
+
+bool SaveLogs::sentryAdmits(int64_t now) {
+    // Sampling (xorshift64*, writer thread only)
+    sampleState ^= sampleState >> 12;
+    sampleState ^= sampleState << 25;
+    sampleState ^= sampleState >> 27;
+    double sample = static_cast<double>((sampleState * 0x2545F4914F6CDD1DULL) >> 11) / 9007199254740992.0;
+    if (sample >= options.sentrySampleRate) return false;
 
+    // Rate cap (token bucket)
+    double elapsed = static_cast<double>(now - sentryLastRefill) / 1e6;
+    sentryLastRefill = now;
+    sentryTokens = min<double>(options.sentryMaxPerSecond, sentryTokens + elapsed * options.sentryMaxPerSecond);
+    if (sentryTokens < 1.0) return false;
+    sentryTokens -= 1.0;
     return true;
 }
+
+void SaveLogs::sendToSentry(const Record& record) {
+    if (!sentryAdmits(nowMicros())) return;
+
+    string method(record.method, strnlen(record.method, sizeof(record.method)));
+    string path(record.path, record.pathLength);
+    string message = "Incoming Request: " + method + " " + path;
+    sentry_value_t event = sentry_value_new_message_event(SENTRY_LEVEL_INFO, "http.request", message.c_str());
+
+    // Tags are set on the event itself, not process-wide
+    sentry_value_t tags = sentry_value_new_object();
+    sentry_value_set_by_key(tags, "app.file", sentry_value_new_string("Logger.cpp"));
+    sentry_value_set_by_key(tags, "app.class", sentry_value_new_string("SaveLogs"));
+    sentry_value_set_by_key(tags, "app.function", sentry_value_new_string("log_request"));
+    sentry_value_set_by_key(tags, "http.ip", sentry_value_new_string(record.ip));
+    sentry_value_set_by_key(tags, "http.method", sentry_value_new_string(method.c_str()));
+    sentry_value_set_by_key(tags, "http.path", sentry_value_new_string(path.c_str()));
+    sentry_value_set_by_key(event, "tags", tags);
+
+    // --- Add Payload as Extra Context ---
+    sentry_value_t extra = sentry_value_new_object();
+    string payload = record.hasPayload ? string(record.payload, record.payloadLength) + (record.payloadTruncated ? "..." : "") : "[N/A]";
+    sentry_value_set_by_key(extra, "request.payload_summary", sentry_value_new_string(payload.c_str()));
+    sentry_value_set_by_key(event, "extra", extra);
+
+    sentry_capture_event(event);
+    sentryCount.fetch_add(1, memory_order_relaxed);
+}
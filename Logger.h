@@ -1,12 +1,92 @@
 // Logger.h file
 // --- Logging Middleware Function ---
+#pragma once
 
 #include <httplib.h>
 
-using namespace std;
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
 
+#include "MpmcQueue.h"
+
+// Request logger for the pre-routing middleware.
+//
+// log_request() only copies the interesting request fields into a fixed-size
+// record and pushes it onto a lock-free ring; it never formats, allocates or
+// touches a file descriptor, and drops the record (counting it) when the ring
+// is full. A background thread drains the ring in batches, formats each batch
+// into one buffer and writes it to stderr with a single write, and forwards
+// a sampled, rate-capped subset to Sentry when Sentry is initialized.
 class SaveLogs {
 public:
-    bool log_request(const httplib::Request &req, Response &res);
-    
-};
\ No newline at end of file
+    struct Options {
+        size_t capacity = 8192;                    // Records in the ring
+        std::chrono::milliseconds flushInterval{50};
+        bool sentryEnabled = false;                // sentry_init() has been called
+        double sentrySampleRate = 0.01;            // Fraction of requests sent to Sentry
+        unsigned int sentryMaxPerSecond = 10;      // Hard cap on Sentry events
+    };
+
+    explicit SaveLogs(const Options& options);
+    ~SaveLogs();
+
+    SaveLogs(const SaveLogs&) = delete;
+    SaveLogs& operator=(const SaveLogs&) = delete;
+
+    bool log_request(const httplib::Request &req, httplib::Response &res);
+
+    // Drains the ring and stops the writer thread
+    void stop();
+
+    unsigned long long dropped() const { return droppedCount.load(std::memory_order_relaxed); }
+    unsigned long long written() const { return writtenCount.load(std::memory_order_relaxed); }
+    unsigned long long sentToSentry() const { return sentryCount.load(std::memory_order_relaxed); }
+
+private:
+    static constexpr size_t MAX_PAYLOAD = 100; // Same summary length as before
+    static constexpr size_t MAX_PATH = 160;
+
+    // Fixed-size, trivially copyable log record
+    struct Record {
+        int64_t timestampMicros = 0;
+        uint16_t pathLength = 0;
+        uint16_t payloadLength = 0;
+        bool payloadTruncated = false;
+        bool hasPayload = false;
+        char method[8] = {};
+        char ip[46] = {};    // INET6_ADDRSTRLEN
+        char path[MAX_PATH] = {};
+        char payload[MAX_PAYLOAD] = {};
+    };
+
+    void run();
+    size_t drain(std::string& buffer);
+    void format(const Record& record, std::string& buffer);
+    void sendToSentry(const Record& record);
+    bool sentryAdmits(int64_t nowMicros);
+
+    Options options;
+    MpmcQueue<Record> ring;
+
+    std::atomic<unsigned long long> droppedCount{0};
+    std::atomic<unsigned long long> writtenCount{0};
+    std::atomic<unsigned long long> sentryCount{0};
+
+    // Writer thread state only
+    unsigned long long droppedReported = 0;
+    int64_t cachedSecond = -1;
+    char cachedTime[24] = {};
+    uint64_t sampleState = 0x9e3779b97f4a7c15ULL;
+    double sentryTokens = 0;
+    int64_t sentryLastRefill = 0;
+
+    std::mutex wakeMutex;
+    std::condition_variable wakeCv;
+    bool stopping = false;
+    std::thread writer;
+};
@@ -0,0 +1,10 @@
+#pragma once
+
+#include <string>
+
+struct EndpointStat {
+    std::string endpoint;
+    std::string endpoint_type;      // HTTP method
+    unsigned long long count = 0;   // Hits to add (delta when flushed in batches)
+    std::string created_by;         // Last client IP seen
+};
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstdint>
 #include <string>
 #include <memory> 
 #include <optional> // Using optional for cleaner clicks/analytics integration
@@ -14,4 +15,5 @@ struct ShortenedLink {
     unsigned int clicks = 0;              // Handles Link Analytics
     std::string created_at;
     std::string updated_at;               // Added for consistency with DB update field
+    uint64_t url_hash = 0;                // Hash of the canonical original_url (dedupe), 0 = not set
 };
\ No newline at end of file
@@ -0,0 +1,141 @@
+#include "RateLimiter.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <functional>
+#include <limits>
+
+#include <arpa/inet.h>
+
+using std::lock_guard;
+using std::mutex;
+using std::string;
+
+namespace {
+
+uint64_t mix64(uint64_t x) {
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return x;
+}
+
+uint64_t loadBigEndian64(const unsigned char* bytes) {
+    uint64_t value = 0;
+    for (int i = 0; i < 8; ++i) value = (value << 8) | bytes[i];
+    return value;
+}
+
+int64_t nowNanos() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+} // namespace
+
+size_t RateLimiter::IpKeyHash::operator()(const IpKey& key) const {
+    return static_cast<size_t>(mix64(key.hi ^ mix64(key.lo)));
+}
+
+RateLimiter::RateLimiter(double ratePerSecond, double burstTokens, size_t maxClients, size_t shardCount)
+    : rate(ratePerSecond), burst(std::max(1.0, burstTokens)) {
+    if (shardCount == 0) shardCount = 1;
+    // Round up so the total never drops below the requested capacity
+    slotsPerShard = std::max<size_t>(1, (maxClients + shardCount - 1) / shardCount);
+    refillNanos = rate > 0 ? static_cast<int64_t>(burst / rate * 1e9) : std::numeric_limits<int64_t>::max();
+
+    shards.reserve(shardCount);
+    for (size_t i = 0; i < shardCount; ++i) {
+        auto shard = std::make_unique<Shard>();
+        shard->slots.resize(slotsPerShard);
+        shard->index.reserve(slotsPerShard);
+        shards.push_back(std::move(shard));
+    }
+}
+
+RateLimiter::IpKey RateLimiter::makeKey(const string& clientIp) {
+    IpKey key;
+    unsigned char bytes[16] = {0};
+    in_addr v4;
+    if (inet_pton(AF_INET, clientIp.c_str(), &v4) == 1) {
+        // IPv4-mapped IPv6 address, so both families share one key space
+        bytes[10] = 0xff;
+        bytes[11] = 0xff;
+        std::memcpy(bytes + 12, &v4, 4);
+    } else if (inet_pton(AF_INET6, clientIp.c_str(), bytes) != 1) {
+        // Not an address (e.g. a unix socket peer): fall back to a hash of the text
+        key.hi = std::hash<string>{}(clientIp);
+        key.lo = ~key.hi;
+        return key;
+    }
+    key.hi = loadBigEndian64(bytes);
+    key.lo = loadBigEndian64(bytes + 8);
+    return key;
+}
+
+uint32_t RateLimiter::claimSlot(Shard& shard, int64_t now) {
+    if (shard.index.size() < slotsPerShard) {
+        // Slots are handed out in order until the shard is full, so the next one is free
+        return static_cast<uint32_t>(shard.index.size());
+    }
+
+    // CLOCK sweep: a bucket that has refilled completely can go right away,
+    // otherwise give recently used buckets a second chance. Terminates within
+    // two laps because the first lap clears every reference bit.
+    for (;;) {
+        Slot& slot = shard.slots[shard.hand];
+        uint32_t candidate = static_cast<uint32_t>(shard.hand);
+        shard.hand = (shard.hand + 1) % slotsPerShard;
+
+        if (now - slot.lastNanos >= refillNanos || !slot.referenced) {
+            shard.index.erase(slot.key);
+            evictionCount.fetch_add(1, std::memory_order_relaxed);
+            return candidate;
+        }
+        slot.referenced = false;
+    }
+}
+
+bool RateLimiter::allow(const string& clientIp) {
+    IpKey key = makeKey(clientIp);
+    size_t hash = IpKeyHash{}(key);
+    Shard& shard = *shards[(hash >> 32) % shards.size()];
+    int64_t now = nowNanos();
+
+    lock_guard<mutex> lock(shard.mutex);
+
+    Slot* slot;
+    auto it = shard.index.find(key);
+    if (it != shard.index.end()) {
+        slot = &shard.slots[it->second];
+        double elapsed = static_cast<double>(now - slot->lastNanos) / 1e9;
+        slot->tokens = static_cast<float>(std::min(burst, slot->tokens + elapsed * rate));
+    } else {
+        uint32_t index = claimSlot(shard, now);
+        slot = &shard.slots[index];
+        slot->key = key;
+        slot->tokens = static_cast<float>(burst);
+        shard.index.emplace(key, index);
+    }
+    slot->lastNanos = now;
+    slot->referenced = true;
+
+    if (slot->tokens >= 1.0f) {
+        slot->tokens -= 1.0f;
+        return true;
+    }
+    rejectedCount.fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
+
+size_t RateLimiter::trackedClients() const {
+    size_t total = 0;
+    for (const auto& shard : shards) {
+        lock_guard<mutex> lock(shard->mutex);
+        total += shard->index.size();
+    }
+    return total;
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Per-client token-bucket rate limiter with bounded memory.
+//
+// Clients are keyed by their address packed into 16 bytes (IPv4 is stored
+// as ::ffff:a.b.c.d) and spread over independently locked shards. Each shard
+// holds a fixed number of bucket slots; when it is full a CLOCK sweep picks
+// the victim, preferring buckets idle long enough to have refilled to the
+// burst (forgetting those is lossless). Memory therefore never grows past
+// maxClients buckets, however many addresses are seen.
+class RateLimiter {
+public:
+    RateLimiter(double ratePerSecond, double burst, size_t maxClients, size_t shardCount = 64);
+
+    RateLimiter(const RateLimiter&) = delete;
+    RateLimiter& operator=(const RateLimiter&) = delete;
+
+    // Takes one token for the client; false if it is over its rate
+    bool allow(const std::string& clientIp);
+
+    size_t capacity() const { return slotsPerShard * shards.size(); }
+    size_t trackedClients() const;
+    unsigned long long rejected() const { return rejectedCount.load(std::memory_order_relaxed); }
+    unsigned long long evictions() const { return evictionCount.load(std::memory_order_relaxed); }
+
+private:
+    struct IpKey {
+        uint64_t hi = 0;
+        uint64_t lo = 0;
+        bool operator==(const IpKey& other) const { return hi == other.hi && lo == other.lo; }
+    };
+
+    struct IpKeyHash {
+        size_t operator()(const IpKey& key) const;
+    };
+
+    struct Slot {
+        IpKey key;
+        int64_t lastNanos = 0; // steady_clock time of the last refill
+        float tokens = 0.0f;
+        bool referenced = false;
+    };
+
+    struct alignas(64) Shard {
+        std::mutex mutex;
+        std::vector<Slot> slots;
+        std::unordered_map<IpKey, uint32_t, IpKeyHash> index;
+        size_t hand = 0;
+    };
+
+    static IpKey makeKey(const std::string& clientIp);
+    uint32_t claimSlot(Shard& shard, int64_t now);
+
+    std::vector<std::unique_ptr<Shard>> shards;
+    size_t slotsPerShard;
+    double rate;
+    double burst;
+    int64_t refillNanos; // Time for an empty bucket to refill completely
+
+    std::atomic<unsigned long long> rejectedCount{0};
+    std::atomic<unsigned long long> evictionCount{0};
+};
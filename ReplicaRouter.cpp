@@ -0,0 +1,100 @@
+#include "ReplicaRouter.h"
+
+#include <limits>
+
+using std::lock_guard;
+using std::mutex;
+
+namespace {
+// How long a replica stays out of rotation after it failed to hand out a session
+constexpr int64_t DOWN_NANOS = 5LL * 1000 * 1000 * 1000;
+}
+
+ReplicaRouter::ReplicaRouter(std::chrono::milliseconds stickyWindow) : window(stickyWindow) {}
+
+int64_t ReplicaRouter::nowNanos() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// FNV-1a over the namespace tag and the id
+uint64_t ReplicaRouter::hashKey(Key kind, std::string_view id) {
+    uint64_t hash = 1469598103934665603ULL;
+    hash ^= static_cast<unsigned char>(kind);
+    hash *= 1099511628211ULL;
+    for (unsigned char c : id) {
+        hash ^= c;
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+void ReplicaRouter::addReplica(const std::string& name, std::unique_ptr<ConnectionPool> pool) {
+    auto replica = std::make_unique<Replica>();
+    replica->name = name;
+    replica->pool = std::move(pool);
+    replicas.push_back(std::move(replica));
+}
+
+void ReplicaRouter::noteWrite(Key kind, std::string_view id) {
+    if (replicas.empty()) return;
+    uint64_t hash = hashKey(kind, id);
+    int64_t now = nowNanos();
+    Shard& shard = shards[hash % SHARD_COUNT];
+
+    lock_guard<mutex> lock(shard.mutex);
+    if (shard.until.size() >= PURGE_THRESHOLD) {
+        for (auto it = shard.until.begin(); it != shard.until.end();) {
+            it = it->second <= now ? shard.until.erase(it) : std::next(it);
+        }
+    }
+    shard.until[hash] = now + window.count();
+}
+
+bool ReplicaRouter::isSticky(Key kind, std::string_view id) const {
+    uint64_t hash = hashKey(kind, id);
+    const Shard& shard = shards[hash % SHARD_COUNT];
+
+    lock_guard<mutex> lock(shard.mutex);
+    auto it = shard.until.find(hash);
+    return it != shard.until.end() && it->second > nowNanos();
+}
+
+ReplicaRouter::Replica* ReplicaRouter::pick() {
+    const size_t count = replicas.size();
+    if (count == 0) return nullptr;
+
+    int64_t now = nowNanos();
+    size_t start = rotation.fetch_add(1, std::memory_order_relaxed);
+    Replica* best = nullptr;
+    int bestOutstanding = std::numeric_limits<int>::max();
+    for (size_t i = 0; i < count; ++i) {
+        Replica* candidate = replicas[(start + i) % count].get();
+        if (candidate->downUntil.load(std::memory_order_relaxed) > now) continue;
+        int outstanding = candidate->outstanding.load(std::memory_order_relaxed);
+        if (outstanding < bestOutstanding) {
+            best = candidate;
+            bestOutstanding = outstanding;
+        }
+    }
+    if (best) {
+        best->outstanding.fetch_add(1, std::memory_order_relaxed);
+        best->reads.fetch_add(1, std::memory_order_relaxed);
+    }
+    return best;
+}
+
+void ReplicaRouter::finished(Replica* replica) {
+    if (replica) replica->outstanding.fetch_sub(1, std::memory_order_relaxed);
+}
+
+void ReplicaRouter::markDown(Replica* replica) {
+    replica->failures.fetch_add(1, std::memory_order_relaxed);
+    replica->downUntil.store(nowNanos() + DOWN_NANOS, std::memory_order_relaxed);
+}
+
+void ReplicaRouter::stop() {
+    for (auto& replica : replicas) {
+        replica->pool->stop();
+    }
+}
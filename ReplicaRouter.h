@@ -0,0 +1,83 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "ConnectionPool.h"
+
+// Read-only replica pools for the pure-read queries.
+//
+// pick() returns the healthy replica with the fewest reads in flight
+// (least outstanding requests). Ties rotate, so idle replicas share the load.
+// A replica whose pool fails to hand out a session is skipped for a few
+// seconds and the read goes to the primary instead.
+//
+// Read-your-writes: writes made through this instance mark the rows they touch
+// (a user, a short code, a session token, ...) as "recently written". Reads
+// of a recently written row go to the primary for stickyWindow, which is
+// long enough to cover replication lag. Stickiness is per process.
+class ReplicaRouter {
+public:
+    struct Replica {
+        std::string name; // host:port
+        std::unique_ptr<ConnectionPool> pool;
+        std::atomic<int> outstanding{0};
+        std::atomic<int64_t> downUntil{0}; // steady_clock nanoseconds
+        std::atomic<unsigned long long> reads{0};
+        std::atomic<unsigned long long> failures{0};
+    };
+
+    // What a sticky key refers to; the same id can exist in several namespaces
+    enum class Key : char { User = 'u', ShortCode = 'c', Token = 't' };
+
+    explicit ReplicaRouter(std::chrono::milliseconds stickyWindow);
+
+    void addReplica(const std::string& name, std::unique_ptr<ConnectionPool> pool);
+    size_t size() const { return replicas.size(); }
+    const std::vector<std::unique_ptr<Replica>>& all() const { return replicas; }
+
+    void noteWrite(Key kind, std::string_view id);
+    bool isSticky(Key kind, std::string_view id) const;
+
+    // Least-outstanding healthy replica with its outstanding count already
+    // taken, or nullptr when none is available. Pair with finished().
+    Replica* pick();
+    void finished(Replica* replica);
+    // The replica could not serve a session: take it out of rotation for a while
+    void markDown(Replica* replica);
+
+    void stop();
+
+    unsigned long long stickyReads() const { return stickyCount.load(std::memory_order_relaxed); }
+    unsigned long long primaryFallbacks() const { return fallbackCount.load(std::memory_order_relaxed); }
+    void countSticky() { stickyCount.fetch_add(1, std::memory_order_relaxed); }
+    void countFallback() { fallbackCount.fetch_add(1, std::memory_order_relaxed); }
+
+private:
+    static constexpr size_t SHARD_COUNT = 16;
+    static constexpr size_t PURGE_THRESHOLD = 4096; // Entries per shard before expired ones are swept
+
+    struct Shard {
+        mutable std::mutex mutex;
+        std::unordered_map<uint64_t, int64_t> until; // key hash -> sticky until (steady ns)
+    };
+
+    static uint64_t hashKey(Key kind, std::string_view id);
+    static int64_t nowNanos();
+
+    std::chrono::nanoseconds window;
+    std::vector<std::unique_ptr<Replica>> replicas;
+    std::atomic<size_t> rotation{0};
+    std::array<Shard, SHARD_COUNT> shards;
+
+    std::atomic<unsigned long long> stickyCount{0};
+    std::atomic<unsigned long long> fallbackCount{0};
+};
@@ -0,0 +1,127 @@
+#include "RevocationList.h"
+#include "URLShortnerDB.h"
+
+#include <algorithm>
+#include <iostream>
+
+using std::cerr;
+using std::endl;
+using std::lock_guard;
+using std::mutex;
+using std::string;
+using std::unique_lock;
+
+RevocationList::RevocationList(UrlShortenerDB& db_instance, std::chrono::seconds interval)
+    : db(db_instance), syncInterval(interval) {
+    sync();
+    syncer = std::thread(&RevocationList::run, this);
+}
+
+RevocationList::~RevocationList() {
+    stop();
+}
+
+uint64_t RevocationList::tokenHash(const string& token) {
+    uint64_t hash = 1469598103934665603ULL;
+    for (unsigned char c : token) {
+        hash = (hash ^ c) * 1099511628211ULL;
+    }
+    return hash;
+}
+
+bool RevocationList::isRevoked(const string& token) const {
+    uint64_t hash = tokenHash(token);
+    std::shared_lock<std::shared_mutex> lock(setMutex);
+    return revoked.count(hash) != 0;
+}
+
+void RevocationList::add(const string& token) {
+    uint64_t hash = tokenHash(token);
+    std::unique_lock<std::shared_mutex> lock(setMutex);
+    revoked.insert(hash);
+    localRevocations.emplace_back(hash, generation);
+}
+
+bool RevocationList::sync() {
+    lock_guard<mutex> syncLock(syncMutex);
+
+    uint64_t startedAt;
+    {
+        std::unique_lock<std::shared_mutex> lock(setMutex);
+        startedAt = ++generation;
+    }
+
+    auto tokens = db.getRevokedSessionTokens();
+    if (!tokens) {
+        cerr << "AUTH_WARN: Could not sync the token revocation list, keeping the previous one." << endl;
+        return false;
+    }
+
+    std::unordered_set<uint64_t> fresh;
+    fresh.reserve(tokens->size());
+    for (const auto& token : *tokens) {
+        fresh.insert(tokenHash(token));
+    }
+
+    std::unique_lock<std::shared_mutex> lock(setMutex);
+    // Local revocations made since the SELECT started may not be in its result yet
+    auto stale = std::remove_if(localRevocations.begin(), localRevocations.end(),
+                                [startedAt](const std::pair<uint64_t, uint64_t>& entry) {
+                                    return entry.second < startedAt; // Made before the SELECT, so it is in the result
+                                });
+    localRevocations.erase(stale, localRevocations.end());
+    for (const auto& entry : localRevocations) {
+        fresh.insert(entry.first);
+    }
+    revoked.swap(fresh);
+    return true;
+}
+
+void RevocationList::purgeExpired() {
+    long long total = 0;
+    for (int batch = 0; batch < PURGE_MAX_BATCHES; ++batch) {
+        long long deleted = db.purgeExpiredSessions(PURGE_BATCH);
+        if (deleted < 0) return; // Logged by the DB layer, retried next pass
+        total += deleted;
+        if (static_cast<size_t>(deleted) < PURGE_BATCH) break;
+        {
+            lock_guard<mutex> lock(wakeMutex);
+            if (stopping) break;
+        }
+    }
+    if (total > 0) {
+        cerr << "AUTH_INFO: Purged " << total << " expired session rows." << endl;
+    }
+}
+
+void RevocationList::run() {
+    auto lastPurge = std::chrono::steady_clock::now() - PURGE_INTERVAL; // First pass purges
+    unique_lock<mutex> lock(wakeMutex);
+    while (!stopping) {
+        wakeCv.wait_for(lock, syncInterval, [this] { return stopping; });
+        if (stopping) break;
+
+        lock.unlock();
+        sync();
+        if (std::chrono::steady_clock::now() - lastPurge >= PURGE_INTERVAL) {
+            purgeExpired();
+            lastPurge = std::chrono::steady_clock::now();
+        }
+        lock.lock();
+    }
+}
+
+void RevocationList::stop() {
+    {
+        lock_guard<mutex> lock(wakeMutex);
+        if (stopping) return;
+        stopping = true;
+    }
+    wakeCv.notify_one();
+    if (syncer.joinable()) syncer.join();
+}
+
+size_t RevocationList::size() const {
+    std::shared_lock<std::shared_mutex> lock(setMutex);
+    return revoked.size();
+}
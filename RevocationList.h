@@ -0,0 +1,69 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+class UrlShortenerDB;
+
+// In-memory set of revoked signed session tokens.
+//
+// Signed tokens are verified without the database, so a logout has to reach
+// every instance some other way: the background thread reloads the revoked,
+// not yet expired rows of the sessions table every syncInterval. Only a
+// 64-bit hash of each token is kept; a collision can only revoke a token
+// too many, never accept a revoked one.
+//
+// Rows of signed tokens are never looked up by token, so nothing else
+// deletes them: the same thread purges expired rows every PURGE_INTERVAL.
+class RevocationList {
+public:
+    RevocationList(UrlShortenerDB& db, std::chrono::seconds syncInterval);
+    ~RevocationList();
+
+    RevocationList(const RevocationList&) = delete;
+    RevocationList& operator=(const RevocationList&) = delete;
+
+    bool isRevoked(const std::string& token) const;
+
+    // Revocation done by this instance, effective here before the next sync
+    void add(const std::string& token);
+
+    // Reloads the list from the DB (also called by the background thread)
+    bool sync();
+    void stop();
+
+    size_t size() const;
+
+private:
+    static constexpr std::chrono::minutes PURGE_INTERVAL{10};
+    static constexpr size_t PURGE_BATCH = 1000;
+    static constexpr int PURGE_MAX_BATCHES = 100; // Per pass, the rest waits for the next one
+
+    static uint64_t tokenHash(const std::string& token);
+    void purgeExpired();
+    void run();
+
+    UrlShortenerDB& db;
+    std::chrono::seconds syncInterval;
+
+    mutable std::shared_mutex setMutex;
+    std::unordered_set<uint64_t> revoked;
+    // Local revocations with the sync generation they were made in, so a sync
+    // whose SELECT started before the UPDATE committed does not drop them
+    std::vector<std::pair<uint64_t, uint64_t>> localRevocations;
+    uint64_t generation = 0;
+
+    std::mutex syncMutex;
+    std::mutex wakeMutex;
+    std::condition_variable wakeCv;
+    bool stopping = false;
+    std::thread syncer;
+};
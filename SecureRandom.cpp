@@ -0,0 +1,200 @@
+#include "SecureRandom.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <mutex>
+#include <stdexcept>
+
+#include <pthread.h>
+#include <sys/random.h>
+
+namespace {
+
+constexpr size_t BLOCK_BYTES = 64;
+constexpr size_t BUFFER_BLOCKS = 16;
+constexpr size_t BUFFER_BYTES = BLOCK_BYTES * BUFFER_BLOCKS;
+constexpr size_t KEY_BYTES = 32;
+constexpr uint64_t RESEED_BYTES = uint64_t(1) << 20;
+constexpr std::chrono::minutes RESEED_INTERVAL(5);
+
+// Bumped in the child after fork(), so it never replays the parent's stream
+std::atomic<uint64_t> forkGeneration{0};
+std::once_flag atforkOnce;
+
+// Plain memset may be optimized away on memory that is not read again
+void wipe(void* data, size_t length) {
+    volatile uint8_t* p = static_cast<volatile uint8_t*>(data);
+    while (length--) *p++ = 0;
+}
+
+uint32_t rotl(uint32_t value, int count) {
+    return (value << count) | (value >> (32 - count));
+}
+
+uint32_t load32(const uint8_t* p) {
+    return uint32_t(p[0]) | (uint32_t(p[1]) << 8) | (uint32_t(p[2]) << 16) | (uint32_t(p[3]) << 24);
+}
+
+void store32(uint8_t* p, uint32_t value) {
+    p[0] = static_cast<uint8_t>(value);
+    p[1] = static_cast<uint8_t>(value >> 8);
+    p[2] = static_cast<uint8_t>(value >> 16);
+    p[3] = static_cast<uint8_t>(value >> 24);
+}
+
+#define CHACHA_QUARTER_ROUND(a, b, c, d) \
+    x[a] += x[b]; x[d] = rotl(x[d] ^ x[a], 16); \
+    x[c] += x[d]; x[b] = rotl(x[b] ^ x[c], 12); \
+    x[a] += x[b]; x[d] = rotl(x[d] ^ x[a], 8);  \
+    x[c] += x[d]; x[b] = rotl(x[b] ^ x[c], 7);
+
+// One ChaCha20 block (RFC 8439) with a zero nonce; the key changes on every refill
+void chachaBlock(const uint32_t key[8], uint32_t counter, uint8_t out[BLOCK_BYTES]) {
+    const uint32_t input[16] = {
+        0x61707865, 0x3320646e, 0x79622d32, 0x6b206574,
+        key[0], key[1], key[2], key[3], key[4], key[5], key[6], key[7],
+        counter, 0, 0, 0
+    };
+    uint32_t x[16];
+    std::memcpy(x, input, sizeof(x));
+    for (int round = 0; round < 10; ++round) {
+        CHACHA_QUARTER_ROUND(0, 4, 8, 12)
+        CHACHA_QUARTER_ROUND(1, 5, 9, 13)
+        CHACHA_QUARTER_ROUND(2, 6, 10, 14)
+        CHACHA_QUARTER_ROUND(3, 7, 11, 15)
+        CHACHA_QUARTER_ROUND(0, 5, 10, 15)
+        CHACHA_QUARTER_ROUND(1, 6, 11, 12)
+        CHACHA_QUARTER_ROUND(2, 7, 8, 13)
+        CHACHA_QUARTER_ROUND(3, 4, 9, 14)
+    }
+    for (int i = 0; i < 16; ++i) store32(out + 4 * i, x[i] + input[i]);
+    wipe(x, sizeof(x));
+}
+
+#undef CHACHA_QUARTER_ROUND
+
+void systemRandom(uint8_t* out, size_t length) {
+    while (length > 0) {
+        ssize_t n = getrandom(out, length, 0);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            throw std::runtime_error(std::string("getrandom failed: ") + std::strerror(errno));
+        }
+        out += n;
+        length -= static_cast<size_t>(n);
+    }
+}
+
+class Generator {
+public:
+    ~Generator() {
+        wipe(key, sizeof(key));
+        wipe(buffer, sizeof(buffer));
+    }
+
+    void fill(uint8_t* out, size_t length) {
+        // A forked child must not hand out what the parent had buffered
+        if (generation != forkGeneration.load(std::memory_order_relaxed)) available = 0;
+
+        while (length > 0) {
+            if (available == 0) refill();
+            size_t take = std::min(length, available);
+            uint8_t* source = buffer + BUFFER_BYTES - available;
+            std::memcpy(out, source, take);
+            wipe(source, take);
+            out += take;
+            length -= take;
+            available -= take;
+            sinceSeed += take;
+        }
+    }
+
+private:
+    void seed() {
+        uint8_t fresh[KEY_BYTES];
+        systemRandom(fresh, sizeof(fresh));
+        for (size_t i = 0; i < 8; ++i) key[i] = load32(fresh + 4 * i);
+        wipe(fresh, sizeof(fresh));
+        sinceSeed = 0;
+        seededAt = std::chrono::steady_clock::now();
+        generation = forkGeneration.load(std::memory_order_relaxed);
+    }
+
+    void refill() {
+        if (generation != forkGeneration.load(std::memory_order_relaxed) || sinceSeed >= RESEED_BYTES ||
+            std::chrono::steady_clock::now() - seededAt >= RESEED_INTERVAL) {
+            seed();
+        }
+        for (uint32_t block = 0; block < BUFFER_BLOCKS; ++block) {
+            chachaBlock(key, block, buffer + block * BLOCK_BYTES);
+        }
+        // Fast key erasure: the head of the keystream is the next key, never output
+        for (size_t i = 0; i < 8; ++i) key[i] = load32(buffer + 4 * i);
+        wipe(buffer, KEY_BYTES);
+        available = BUFFER_BYTES - KEY_BYTES;
+    }
+
+    uint32_t key[8] = {};
+    uint8_t buffer[BUFFER_BYTES] = {};
+    size_t available = 0; // Unused bytes at the end of buffer
+    uint64_t sinceSeed = 0;
+    uint64_t generation = ~uint64_t(0); // Never matches, so the first use seeds
+    std::chrono::steady_clock::time_point seededAt;
+};
+
+Generator& localGenerator() {
+    std::call_once(atforkOnce, [] {
+        pthread_atfork(nullptr, nullptr, [] { forkGeneration.fetch_add(1, std::memory_order_relaxed); });
+    });
+    thread_local Generator generator;
+    return generator;
+}
+
+// byte -> base62 character, or 0 to reject. 248 = 4 * 62 values are kept,
+// so every character is hit by exactly four byte values.
+struct Base62Table {
+    char map[256];
+};
+
+constexpr Base62Table makeBase62Table() {
+    constexpr char ALPHABET[] = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz";
+    Base62Table table{};
+    for (int b = 0; b < 248; ++b) table.map[b] = ALPHABET[b % 62];
+    return table;
+}
+
+constexpr Base62Table BASE62 = makeBase62Table();
+
+} // namespace
+
+void SecureRandom::fill(uint8_t* out, size_t length) {
+    localGenerator().fill(out, length);
+}
+
+void SecureRandom::base62(char* out, size_t length) {
+    Generator& generator = localGenerator();
+    uint8_t bytes[128];
+    size_t written = 0;
+    while (written < length) {
+        // About 3% of bytes are rejected; ask for a little more than needed
+        size_t missing = length - written;
+        size_t count = std::min(sizeof(bytes), missing + missing / 16 + 4);
+        generator.fill(bytes, count);
+        // Branch-free: always store, only advance on an accepted byte
+        for (size_t i = 0; i < count && written < length; ++i) {
+            char c = BASE62.map[bytes[i]];
+            out[written] = c;
+            written += (c != 0);
+        }
+    }
+    wipe(bytes, sizeof(bytes));
+}
+
+std::string SecureRandom::base62(size_t length) {
+    std::string text(length, '\0');
+    base62(&text[0], length);
+    return text;
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Cryptographically secure random bytes and base62 strings for short codes,
+// OAuth states and session tokens.
+//
+// Each thread has its own ChaCha20 generator, so calls take no lock and make
+// no syscall. It produces keystream 1 KiB at a time and uses fast key
+// erasure: the first 32 bytes of every refill become the next key, and
+// bytes are wiped once handed out, so a later memory dump cannot recover
+// earlier output. The key is reseeded from getrandom() on first use, every
+// 1 MiB of output, every 5 minutes and after fork().
+class SecureRandom {
+public:
+    static void fill(uint8_t* out, size_t length);
+
+    // Writes length characters from [0-9A-Za-z] to out, each uniformly
+    // distributed (rejection sampling, no modulo bias)
+    static void base62(char* out, size_t length);
+    static std::string base62(size_t length);
+};
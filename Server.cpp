@@ -1,8 +1,11 @@
 
 #include "Server.h"
+#include "JsonReader.h"
+#include "JsonWriter.h"
+#include "UrlCanonicalizer.h"
+#include "SecureRandom.h"
 
 #include <algorithm>
-#include <random>
 #include <sstream>
 #include <chrono>
 #include <algorithm>
@@ -10,6 +13,8 @@
 #include <utility>
 #include <stdexcept>
 #include <ctime>
+#include <limits>
+#include <memory>
 
 using namespace std;
 
@@ -19,81 +24,62 @@ using Headers = httplib::Headers;
 std::unordered_map<std::string, std::chrono::steady_clock::time_point> oauthStates;
 std::mutex oauthStatesMutex;
 
-struct Bucket {
-    double tokens = 10.0;
-    chrono::steady_clock::time_point last = Clock::now();
-};
-
-unordered_map<string, Bucket> buckets;
-mutex bucketMutex;
-
-bool checkBucket(const string &ip) {
-    const double MAX_TOKENS = 10.0;
-    const double REFILL_RATE = 2.0; // tokens per second
-    auto now = Clock::now();
-    unique_lock<mutex> lock(bucketMutex);
-    auto &b = buckets[ip];
-    double elapsed = chrono::duration<double>(now - b.last).count();
-    b.tokens = min(MAX_TOKENS, b.tokens + elapsed * REFILL_RATE);
-    b.last = now;
-    if (b.tokens >= 1.0) {
-        b.tokens -= 1.0;
-        return true;
+// --- for google sign in ---
+std::string UrlShortenerServer::generateRandomState(size_t length) {
+    return SecureRandom::base62(length);
+}
+
+// Function to generate a session token: signed when keys are configured, otherwise opaque
+std::string UrlShortenerServer::createSessionToken(unsigned int userId, const std::string& email, std::time_t expires) {
+    if (tokenSigner.enabled()) {
+        TokenClaims claims;
+        claims.userId = userId;
+        claims.isAdmin = (userId == 1);
+        claims.expires = expires;
+        return tokenSigner.issue(claims, generateRandomState(16));
     }
 
-    return false;
+    // Opaque token: only the random tail is secret, 32 base62 characters carry ~190 bits
+    static constexpr size_t SECRET_LENGTH = 32;
+    std::string token = "sess_usr_" + std::to_string(userId) + "_";
+    const size_t prefix = token.size();
+    token.resize(prefix + SECRET_LENGTH);
+    SecureRandom::base62(&token[prefix], SECRET_LENGTH);
+    return token;
 }
 
-// --- for google sign in ---
-std::string UrlShortenerServer::getJsonValue(const std::string& json, const std::string& key) {
-    std::string searchKey = "\"" + key + "\":";
-    size_t start = json.find(searchKey);
-    if (start == std::string::npos) return "";
 
-    start += searchKey.length();
-    
-    // Skip optional whitespace and check for opening quote
-    while (start < json.length() && (json[start] == ' ' || json[start] == '\t')) {
-        start++;
-    }
 
-    if (json[start] != '"') {
-        return ""; 
+// Handler for logging out: revokes the session so the token stops working on every instance
+void UrlShortenerServer::handleLogout(const httplib::Request &req, httplib::Response &res) {
+    const RequestContext& ctx = get_context();
+    if (!ctx.isAuthenticated) {
+        res.status = 401;
+        res.set_content("Unauthorized: No valid session to log out.", "text/plain");
+        return;
     }
-    
-    start++; // Move past the opening quote
-    size_t end = json.find('"', start);
-    
-    if (end == std::string::npos) return "";
-
-    return json.substr(start, end - start);
-}
 
-std::string UrlShortenerServer::generateRandomState(size_t length) {
-    const std::string CHARACTERS = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz";
-    std::random_device random_device;
-    std::mt19937 generator(random_device());
-    std::uniform_int_distribution<> distribution(0, CHARACTERS.size() - 1);
-
-    std::string random_string;
-    for (size_t i = 0; i < length; ++i)
-        random_string += CHARACTERS[distribution(generator)];
-    return random_string;
-}
+    // AuthMiddleware already accepted the header, so the prefix is there
+    std::string token = req.get_header_value("Authorization").substr(7);
+    // A signed token's row must outlive the token, or the revocation would be forgotten
+    TokenClaims claims;
+    const bool isSigned = SessionTokenSigner::isSignedToken(token) && tokenSigner.verify(token, claims);
+    if (!db.revokeSession(token, isSigned ? claims.userId : 0, isSigned ? claims.expires : 0)) {
+        res.status = 500;
+        res.set_content("Logout failed.", "text/plain");
+        return;
+    }
+    if (revokedTokens && isSigned) {
+        revokedTokens->add(token);
+    }
 
-// Function to generate a session token (simplistic UUID for testing)
-std::string UrlShortenerServer::createSessionToken(unsigned int userId, const std::string& email) {
-    // In a real application, this would be a secure JWT or a cryptographically secure random string.
-    std::stringstream ss;
-    ss << "sess_usr_" << userId << "_" << generateRandomState(16);
-    return ss.str();
+    res.status = 200;
+    res.set_content("Logged out.", "text/plain");
 }
 
-
-
 // Handler for setting favorite status
 void UrlShortenerServer::handleLinkFavorite(const httplib::Request &req, httplib::Response &res) {
-    RequestContext ctx = get_context(res);
+    const RequestContext& ctx = get_context();
     
     if (!ctx.isAuthenticated || !checkUserRole(ctx, "user")) {
         res.status = 403;
@@ -101,8 +87,16 @@ void UrlShortenerServer::handleLinkFavorite(const httplib::Request &req, httplib
         return;
     }
     
-    std::string code = extractShortUrl(req.body); 
-    bool isFav = req.body.find("\"is_favourite\":true") != string::npos; 
+    JsonReader request(req.body);
+    if (!request.parse()) {
+        res.status = 400;
+        res.set_content(string("Malformed JSON body: ") + request.error() + ".", "text/plain");
+        return;
+    }
+    string scratch;
+    string code(request.getString("short_code", scratch));
+    bool isFav = false;
+    request.getBool("is_favourite", isFav);
     
     if (code.empty()) {
         res.status = 400;
@@ -110,7 +104,6 @@ void UrlShortenerServer::handleLinkFavorite(const httplib::Request &req, httplib
         return;
     }
 
-    unique_lock<mutex> lock(dbMutex);
     if (db.setLinkFavorite(ctx.userId, code, isFav)) {
         res.status = 200;
         res.set_content("Favourite status updated successfully.", "text/plain");
@@ -122,7 +115,7 @@ void UrlShortenerServer::handleLinkFavorite(const httplib::Request &req, httplib
 
 // Handler for deleting a link
 void UrlShortenerServer::handleLinkDelete(const httplib::Request &req, httplib::Response &res) {
-    RequestContext ctx = get_context(res);
+    const RequestContext& ctx = get_context();
     
     if (!ctx.isAuthenticated || !checkUserRole(ctx, "user")) {
         res.status = 403;
@@ -138,7 +131,6 @@ void UrlShortenerServer::handleLinkDelete(const httplib::Request &req, httplib::
         return;
     }
 
-    unique_lock<mutex> lock(dbMutex);
     // Using ctx.userId explicitly for clarity, assuming db.deleteLink takes userId first
     if (db.deleteLink(ctx.userId, code)) { 
         res.status = 200;
@@ -151,7 +143,7 @@ void UrlShortenerServer::handleLinkDelete(const httplib::Request &req, httplib::
 
 // Handler for Admin-Only Test API
 void UrlShortenerServer::handleAdminTest(const httplib::Request &req, httplib::Response &res) {
-    RequestContext ctx = get_context(res);
+    const RequestContext& ctx = get_context();
 
     if (!ctx.isAuthenticated) {
         res.status = 401;
@@ -170,99 +162,249 @@ void UrlShortenerServer::handleAdminTest(const httplib::Request &req, httplib::R
     res.set_content("Welcome, Admin! This is a restricted endpoint.", "text/plain");
 }
 
-// Function to store the RequestContext in the Response object
-void UrlShortenerServer::set_context(httplib::Response &res, const RequestContext &ctx) {
-    // Stores context as a header string (best approach for httplib context passing)
-    stringstream ss;
-    ss << "Auth:" << (ctx.isAuthenticated ? "true" : "false")
-       << ",Id:" << ctx.userId
-       << ",Role:" << ctx.userRole;
-    res.set_header("X-App-Context", ss.str());
+// Handler for Admin-Only reload of the global_settings snapshot
+void UrlShortenerServer::handleAdminReloadSettings(const httplib::Request &, httplib::Response &res) {
+    const RequestContext& ctx = get_context();
+
+    if (!ctx.isAuthenticated || ctx.userRole != "admin") {
+        res.status = ctx.isAuthenticated ? 403 : 401;
+        res.set_content("Forbidden: This API requires 'admin' role.", "text/plain");
+        return;
+    }
+
+    bool reloaded = db.reloadGlobalSettings();
+    auto settings = db.getSettings();
+
+    string body;
+    JsonWriter json(body);
+    json.beginObject()
+        .field("reloaded", reloaded)
+        .field("version", settings->version)
+        .field("loaded_at", settings->loadedAt)
+        .field("max_link_limit_enabled", settings->maxLinkLimitEnabled)
+        .field("max_guest_links_per_day", settings->maxGuestLinksPerDay)
+        .endObject();
+
+    res.status = reloaded ? 200 : 503;
+    res.set_content(std::move(body), "application/json");
 }
 
-// Function to retrieve the RequestContext from the Response object
-RequestContext UrlShortenerServer::get_context(const httplib::Response &res) {
-    RequestContext ctx;
-    string contextHeader = res.get_header_value("X-App-Context");
-    
-    // Crude parsing for demonstration:
-    if (contextHeader.find("Auth:true") != string::npos) {
-        ctx.isAuthenticated = true;
-        // Simple extraction of UserId (assuming "Id:XXX" format)
-        size_t id_pos = contextHeader.find("Id:");
-        size_t role_pos = contextHeader.find(",Role:");
-        if (id_pos != string::npos && role_pos != string::npos) {
-            string id_str = contextHeader.substr(id_pos + 3, role_pos - (id_pos + 3));
-            try {
-                ctx.userId = stoul(id_str);
-            } catch (...) {
-                ctx.userId = 0; // Invalid ID
-            }
+// Handler for Admin-Only runtime statistics (caches, filters, ...)
+void UrlShortenerServer::handleAdminStats(const httplib::Request &, httplib::Response &res) {
+    const RequestContext& ctx = get_context();
+
+    if (!ctx.isAuthenticated || ctx.userRole != "admin") {
+        res.status = ctx.isAuthenticated ? 403 : 401;
+        res.set_content("Forbidden: This API requires 'admin' role.", "text/plain");
+        return;
+    }
+
+    string body;
+    body.reserve(2048);
+    JsonWriter json(body);
+    json.beginObject();
+
+    const LinkCache* cache = db.getLinkCache();
+    json.key("link_cache");
+    if (cache) {
+        json.beginObject()
+            .field("size", cache->size())
+            .field("capacity", cache->capacity())
+            .field("hits", cache->hits())
+            .field("misses", cache->misses())
+            .endObject();
+    } else {
+        json.null();
+    }
+
+    json.key("link_dedupe");
+    if (const LinkDedupeIndex* dedupe = db.getLinkDedupe()) {
+        json.beginObject()
+            .field("size", dedupe->size())
+            .field("capacity", dedupe->capacity())
+            .field("hits", dedupe->hits())
+            .field("misses", dedupe->misses())
+            .endObject();
+    } else {
+        json.null();
+    }
+
+    const SessionCache* sessions = db.getSessionCache();
+    json.key("session_cache");
+    if (sessions) {
+        json.beginObject()
+            .field("size", sessions->size())
+            .field("capacity", sessions->capacity())
+            .field("hits", sessions->hits())
+            .field("negative_hits", sessions->negativeHits())
+            .field("misses", sessions->misses())
+            .endObject();
+    } else {
+        json.null();
+    }
+
+    const StatementCacheStats& statements = db.getStatementCacheStats();
+    unsigned long long statementHits = statements.hits.load(memory_order_relaxed);
+    unsigned long long statementPrepares = statements.prepares.load(memory_order_relaxed);
+    unsigned long long statementUses = statementHits + statementPrepares;
+    json.key("statement_cache").beginObject()
+        .field("hits", statementHits)
+        .field("prepares", statementPrepares)
+        .field("hit_rate", statementUses ? static_cast<double>(statementHits) / statementUses : 0.0)
+        .field("server_prepares", db.getServerPrepareCount())
+        .endObject();
+
+    json.key("db_pool");
+    if (const ConnectionPool* pool = db.getConnectionPool()) {
+        ConnectionPool::Stats poolStats = pool->stats();
+        json.beginObject()
+            .field("total", poolStats.total)
+            .field("idle", poolStats.idle)
+            .field("in_use", poolStats.inUse)
+            .field("waiters", poolStats.waiters)
+            .field("acquired", poolStats.acquired)
+            .field("timeouts", poolStats.timeouts)
+            .field("opened", poolStats.opened)
+            .field("closed", poolStats.closed)
+            .field("broken", poolStats.broken)
+            .key("wait_us_histogram").beginArray();
+        // Bucket i counts waits up to WAIT_BUCKETS_US[i]; the last bucket is everything above
+        for (size_t i = 0; i < poolStats.waitHistogram.size(); ++i) {
+            json.beginObject().key("le");
+            if (i < ConnectionPool::WAIT_BUCKETS_US.size()) json.value(ConnectionPool::WAIT_BUCKETS_US[i]);
+            else json.null();
+            json.field("count", poolStats.waitHistogram[i]).endObject();
         }
-        // Role is usually not strictly necessary for checks but is available
-        if (contextHeader.find("Role:admin") != string::npos) {
-            ctx.userRole = "admin";
-        } else {
-            ctx.userRole = "user";
+        json.endArray().endObject();
+    } else {
+        json.null();
+    }
+
+    json.key("replicas");
+    if (const ReplicaRouter* router = db.getReplicaRouter()) {
+        json.beginObject()
+            .field("sticky_reads", router->stickyReads())
+            .field("primary_fallbacks", router->primaryFallbacks())
+            .key("pools").beginArray();
+        for (const auto& replica : router->all()) {
+            ConnectionPool::Stats replicaStats = replica->pool->stats();
+            json.beginObject()
+                .field("name", replica->name)
+                .field("outstanding", replica->outstanding.load(std::memory_order_relaxed))
+                .field("reads", replica->reads.load(std::memory_order_relaxed))
+                .field("failures", replica->failures.load(std::memory_order_relaxed))
+                .field("total", replicaStats.total)
+                .field("idle", replicaStats.idle)
+                .field("timeouts", replicaStats.timeouts)
+                .endObject();
         }
+        json.endArray().endObject();
+    } else {
+        json.null();
     }
-    return ctx;
-}
 
-// Generates a random 8-character alphanumeric short code
-string UrlShortenerServer::generateShortCode(size_t length) {
-    const string CHARACTERS = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz";
-    random_device random_device;
-    mt19937 generator(random_device());
-    uniform_int_distribution<> distribution(0, CHARACTERS.size() - 1);
-
-    string random_string;
-    for (size_t i = 0; i < length; ++i)
-        random_string += CHARACTERS[distribution(generator)];
-    return random_string;
-}
+    json.key("link_batcher");
+    if (linkBatcher) {
+        unsigned long long batches = linkBatcher->batches();
+        json.beginObject()
+            .field("batches", batches)
+            .field("rows", linkBatcher->rows())
+            .field("avg_batch", batches ? static_cast<double>(linkBatcher->rows()) / batches : 0.0)
+            .field("duplicates", linkBatcher->duplicates())
+            .field("fallbacks", linkBatcher->fallbacks())
+            .endObject();
+    } else {
+        json.null();
+    }
 
-string UrlShortenerServer::extractLongUrl(const string &body) {
-    string target = "\"long_url\"";
-    size_t start = body.find(target);
-    if (start == string::npos) return "";
+    auto settings = db.getSettings();
+    json.key("global_settings").beginObject()
+        .field("version", settings->version)
+        .field("loaded_at", settings->loadedAt)
+        .field("keys", settings->values.size())
+        .endObject();
+
+    json.key("guest_quota");
+    if (const GuestQuotaCounter* quota = db.getGuestQuotaCounter()) {
+        json.beginObject()
+            .field("tracked_guests", quota->trackedGuests())
+            .field("rejected", quota->rejected())
+            .field("flush_failures", quota->flushFailures())
+            .endObject();
+    } else {
+        json.null();
+    }
 
-    // Find the first quote after the colon (ignore whitespace)
-    start = body.find(':', start);
-    if (start == string::npos) return "";
+    json.key("request_log").beginObject()
+        .field("written", requestLog.written())
+        .field("dropped", requestLog.dropped())
+        .field("sent_to_sentry", requestLog.sentToSentry())
+        .endObject();
+
+    json.key("short_code_filter");
+    if (const ShortCodeFilter* filter = db.getShortCodeFilter()) {
+        json.beginObject()
+            .field("ready", filter->isReady())
+            .field("items", filter->itemCount())
+            .field("memory_bytes", filter->memoryBytes())
+            .field("false_positive_rate", filter->falsePositiveRate());
+        if (const ShortCodeFilterSync* sync = db.getShortCodeFilterSync()) {
+            json.field("highest_id", sync->highestId())
+                .field("synced", sync->synced())
+                .field("sync_failures", sync->failures());
+        }
+        json.endObject();
+    } else {
+        json.null();
+    }
 
-    // Skip spaces
-    while (start < body.size() && isspace(body[start + 1])) start++;
+    json.key("rate_limiter").beginObject()
+        .field("clients", rateLimiter.trackedClients())
+        .field("capacity", rateLimiter.capacity())
+        .field("rejected", rateLimiter.rejected())
+        .field("evictions", rateLimiter.evictions())
+        .endObject();
 
-    // Find the opening quote
-    start = body.find('"', start);
-    if (start == string::npos) return "";
+    json.key("revoked_tokens");
+    if (revokedTokens) {
+        json.value(revokedTokens->size());
+    } else {
+        json.null();
+    }
 
-    size_t end = body.find('"', start + 1);
-    if (end == string::npos) return "";
+    json.key("code_reservoir");
+    if (codeReservoir) {
+        json.beginObject()
+            .field("depth", codeReservoir->depth())
+            .field("capacity", codeReservoir->capacity())
+            .field("refilled", codeReservoir->refilled())
+            .field("refill_rate_per_sec", codeReservoir->refillRate())
+            .field("empty_pops", codeReservoir->emptyPops())
+            .endObject();
+    } else {
+        json.null();
+    }
 
-    return body.substr(start + 1, end - start - 1);
+    json.endObject();
+    res.status = 200;
+    res.set_content(std::move(body), "application/json");
 }
-string UrlShortenerServer::extractShortUrl(const string &body) {
-    string target = "\"short_code\"";
-    size_t start = body.find(target);
-    if (start == string::npos) return "";
-
-    // Find the first quote after the colon (ignore whitespace)
-    start = body.find(':', start);
-    if (start == string::npos) return "";
 
-    // Skip spaces
-    while (start < body.size() && isspace(body[start + 1])) start++;
+thread_local RequestContext UrlShortenerServer::requestContext;
 
-    // Find the opening quote
-    start = body.find('"', start);
-    if (start == string::npos) return "";
+// Function to store the RequestContext for the current request
+void UrlShortenerServer::set_context(const RequestContext &ctx) {
+    requestContext = ctx;
+}
 
-    size_t end = body.find('"', start + 1);
-    if (end == string::npos) return "";
+// Function to retrieve the RequestContext of the current request
+const RequestContext& UrlShortenerServer::get_context() {
+    return requestContext;
+}
 
-    return body.substr(start + 1, end - start - 1);
+// Generates a random 8-character alphanumeric short code
+string UrlShortenerServer::generateShortCode(size_t length) {
+    return SecureRandom::base62(length);
 }
 
 // Database-backed quota check
@@ -275,9 +417,8 @@ bool UrlShortenerServer::checkAndApplyRateLimitDB(const string &guestId) {
              return true; 
         }
         
-        // Check and update the guest_daily_quotas table
-        unique_lock<mutex> lock(dbMutex);
-        // This method handles both the read and the conditional write
+        // Check and count against the guest's daily quota
+        // Enforced in memory by the DB layer, guest_daily_quotas is updated in the background
         return db.checkAndUpdateGuestQuota(guestId, today); 
 
     } catch (const exception& e) {
@@ -289,15 +430,101 @@ bool UrlShortenerServer::checkAndApplyRateLimitDB(const string &guestId) {
 
 
 // --- Class Implementation ---
-UrlShortenerServer::UrlShortenerServer(UrlShortenerDB& db_instance, std::mutex& db_mutex_ref)
-    : db(db_instance), dbMutex(db_mutex_ref) {
+namespace {
+
+// /api/links paging
+constexpr size_t LINKS_PAGE_DEFAULT = 100;
+constexpr size_t LINKS_PAGE_MAX = 1000;
+constexpr size_t LINKS_STREAM_PAGE = 500; // Rows per chunk in streaming mode
+
+// One /api/links entry, same fields as before plus the cursor fields
+void appendLinkJson(JsonWriter& json, const ShortenedLink& link) {
+    json.beginObject()
+        .field("code", link.short_code)
+        .field("url", link.original_url)
+        .field("clicks", link.clicks) // Link Analytics
+        .field("expires_at", link.expires_at)
+        .field("created_at", link.created_at)
+        .field("id", link.id)
+        .endObject();
+}
+
+// Typical serialized size of one entry, for reserving response buffers
+constexpr size_t LINK_JSON_ESTIMATE = 192;
+
+// "<created_at>,<id>" as returned in "next"
+bool parseLinkCursor(const string& text, LinkCursor& cursor) {
+    size_t comma = text.rfind(',');
+    if (comma == string::npos || comma != 19) return false; // YYYY-MM-DD HH:MM:SS
+    if (UrlShortenerDB::parseTimestamp(text.substr(0, comma)) == 0) return false;
+    const string id = text.substr(comma + 1);
+    if (id.empty() || id.size() > 10 || id.find_first_not_of("0123456789") != string::npos) return false;
+    unsigned long value = std::stoul(id);
+    if (value > std::numeric_limits<unsigned int>::max()) return false;
+    cursor.created_at = text.substr(0, comma);
+    cursor.id = static_cast<unsigned int>(value);
+    return true;
+}
+
+SaveLogs::Options requestLogOptions() {
+    SaveLogs::Options options;
+    options.capacity = Config::LOG_RING_CAPACITY;
+    options.flushInterval = chrono::milliseconds(Config::LOG_FLUSH_INTERVAL_MS);
+    options.sentryEnabled = !Config::SENTRY_DSN.empty();
+    options.sentrySampleRate = Config::LOG_SENTRY_SAMPLE_RATE;
+    options.sentryMaxPerSecond = Config::LOG_SENTRY_MAX_PER_SECOND;
+    return options;
+}
+
+} // namespace
+
+UrlShortenerServer::UrlShortenerServer(UrlShortenerDB& db_instance)
+    : db(db_instance),
+      requestLog(requestLogOptions()),
+      clickCounter(db_instance, chrono::milliseconds(Config::CLICK_FLUSH_INTERVAL_MS), Config::CLICK_FLUSH_THRESHOLD),
+      endpointStats(db_instance, chrono::milliseconds(Config::ENDPOINT_STATS_FLUSH_INTERVAL_MS)),
+      rateLimiter(Config::RATE_LIMIT_RATE, Config::RATE_LIMIT_BURST, Config::RATE_LIMIT_MAX_CLIENTS),
+      tokenSigner(Config::SESSION_TOKEN_KEYS, Config::SESSION_TOKEN_ACTIVE_KEY),
+      codeAllocator(db_instance, Config::SHORT_CODE_BLOCK_SIZE, Config::SHORT_CODE_SCRAMBLE_KEY) {
+    if (tokenSigner.enabled()) {
+        revokedTokens = make_unique<RevocationList>(db_instance, chrono::seconds(Config::TOKEN_REVOCATION_SYNC_SECONDS));
+    }
+    bool randomCodes = Config::SHORT_CODE_STRATEGY == "random";
+    if (!randomCodes && Config::SHORT_CODE_SCRAMBLE_KEY == 0) {
+        // Unscrambled ids are consecutive, anyone could list every link
+        cerr << "CONFIG_WARN: SHORT_CODE_STRATEGY=" << Config::SHORT_CODE_STRATEGY
+             << " needs a private SHORT_CODE_SCRAMBLE_KEY; using random short codes instead." << endl;
+        randomCodes = true;
+    }
+    if (randomCodes) {
+        codeReservoir = make_unique<CodeReservoir>(
+            db_instance, [] { return generateShortCode(); },
+            Config::SHORT_CODE_RESERVOIR_SIZE, Config::SHORT_CODE_RESERVOIR_LOW_WATER, Config::SHORT_CODE_RESERVOIR_BATCH);
+    }
+    if (Config::LINK_GROUP_COMMIT_WINDOW_MS > 0) {
+        linkBatcher = make_unique<LinkBatcher>(db_instance, chrono::milliseconds(Config::LINK_GROUP_COMMIT_WINDOW_MS),
+                                               Config::LINK_GROUP_COMMIT_MAX_ROWS);
+    }
     setupMiddleware();
     setupRoutes();
 }
 
 bool UrlShortenerServer::run() {
     cerr << "Starting URL Shortener Service on port 9080..." << endl;
-    return svr.listen("0.0.0.0", 9080);
+    bool result = svr.listen("0.0.0.0", 9080);
+
+    // No more requests can record clicks now, write out whatever is pending
+    clickCounter.stop();
+    endpointStats.stop();
+    if (linkBatcher) linkBatcher->stop();
+    if (codeReservoir) codeReservoir->stop();
+    if (revokedTokens) revokedTokens->stop();
+    requestLog.stop();
+    return result;
+}
+
+void UrlShortenerServer::stop() {
+    svr.stop();
 }
 // Endpoint Stat Tracking Middleware Implementation
 httplib::Server::HandlerResponse UrlShortenerServer::EndpointStatMiddleware(const httplib::Request &req, httplib::Response &res) {
@@ -309,14 +536,14 @@ httplib::Server::HandlerResponse UrlShortenerServer::EndpointStatMiddleware(cons
     // Simple way to handle the dynamic redirect route /<short_code>
     // Note: This relies on the fact that only '/<short_code>' is a short dynamic path.
     if (httpMethod == "GET") {
-        db.incrementEndpointStat(endpointPath, httpMethod, clientIp);
-        if (endpointPath != "/api/links" && endpointPath != "/api/admin" && endpointPath != "/auth/google/callback") {
+        endpointStats.record(endpointPath, httpMethod, clientIp);
+        if (endpointPath != "/api/links" && endpointPath != "/api/admin" && endpointPath != "/api/admin/stats" && endpointPath != "/auth/google/callback") {
             endpointPath = R"(/(\w+))";
-            db.incrementEndpointStat(endpointPath, httpMethod, clientIp);
+            endpointStats.record(endpointPath, httpMethod, clientIp);
         }
     }
     else {
-        db.incrementEndpointStat(endpointPath, httpMethod, clientIp);
+        endpointStats.record(endpointPath, httpMethod, clientIp);
     }
     return httplib::Server::HandlerResponse::Unhandled;
 }
@@ -328,6 +555,9 @@ void UrlShortenerServer::setupMiddleware() {
     // Register ONE SINGLE pre-routing handler function
     svr.set_pre_routing_handler([this](const httplib::Request &req, httplib::Response &res) {
         
+        // 0. Log the request (only enqueues; formatting and I/O happen on the logger thread)
+        this->requestLog.log_request(req, res);
+
         // 1. Run AuthMiddleware FIRST
         // This includes Rate Limiting and setting the RequestContext
         httplib::Server::HandlerResponse auth_result = this->AuthMiddleware(req, res);
@@ -346,10 +576,8 @@ void UrlShortenerServer::setupMiddleware() {
         return stat_result; 
     });
 
-    /// @todo INTEGRATE LOGGER HERE
-
 }
-bool UrlShortenerServer::checkUserRole(const RequestContext &ctx, const std::string &requiredRole) {
+bool UrlShortenerServer::checkUserRole(const RequestContext &ctx, std::string_view requiredRole) {
     if (ctx.userRole == "admin") {
         return true;
     }
@@ -363,9 +591,10 @@ bool UrlShortenerServer::checkAndApplyUserLimit(unsigned int userId) {
 // Implements Token Expiration Check
 httplib::Server::HandlerResponse UrlShortenerServer::AuthMiddleware(const httplib::Request &req, httplib::Response &res) {
     RequestContext ctx;
+    set_context(ctx); // Never let a previous request's context on this thread leak through
     string token;
     std::string clientIp = req.remote_addr;
-    if (!checkBucket(clientIp)) {
+    if (!rateLimiter.allow(clientIp)) {
         res.status = 429; // Too Many Requests
         res.set_content("Rate limit exceeded. Please slow down.", "text/plain");
         return httplib::Server::HandlerResponse::Handled; // Stop request here
@@ -378,9 +607,17 @@ httplib::Server::HandlerResponse UrlShortenerServer::AuthMiddleware(const httpli
         }
     }
 
-    if (!token.empty()) {
+    if (!token.empty() && tokenSigner.enabled() && SessionTokenSigner::isSignedToken(token)) {
+        // Signed token: checked in memory, no DB round-trip. Forged, expired or
+        // revoked tokens simply stay unauthenticated.
+        TokenClaims claims;
+        if (tokenSigner.verify(token, claims) && !revokedTokens->isRevoked(token)) {
+            ctx.isAuthenticated = true;
+            ctx.userId = claims.userId;
+            ctx.userRole = claims.isAdmin ? "admin" : "user";
+        }
+    } else if (!token.empty()) {
         try {
-            unique_lock<mutex> lock(dbMutex);
             unique_ptr<::Session> sessionObj = db.findSessionByToken(token);
             
             if (sessionObj) {
@@ -388,17 +625,15 @@ httplib::Server::HandlerResponse UrlShortenerServer::AuthMiddleware(const httpli
                 ctx.isAuthenticated = true;
                 ctx.userId = sessionObj->user_id;
                 ctx.userRole = (sessionObj->user_id == 1) ? "admin" : "user";
-            } else {
-                // Token exists but is invalid or expired, delete it from DB (Token Expiration Cleanup)
-                db.deleteSession(token);
             }
+            // Invalid or expired tokens are cached as such (and expired rows cleaned up) by the DB layer
         } catch (const exception& e) {
             cerr << "DB_ERROR in AuthMiddleware: " << e.what() << endl;
             // Fail safely: treat as unauthenticated if DB call fails
         }
     }
 
-    set_context(res, ctx);
+    set_context(ctx);
     return httplib::Server::HandlerResponse::Unhandled;
 }
 
@@ -434,6 +669,16 @@ void UrlShortenerServer::setupRoutes() {
     svr.Get("/api/admin", [this](const httplib::Request &req, httplib::Response &res) {
         this->handleAdminTest(req, res);
     });
+
+    // GET /api/admin/stats - Admin-Only runtime statistics
+    svr.Get("/api/admin/stats", [this](const httplib::Request &req, httplib::Response &res) {
+        this->handleAdminStats(req, res);
+    });
+
+    // POST /api/admin/settings/reload - Admin-Only, picks up global_settings changes now
+    svr.Post("/api/admin/settings/reload", [this](const httplib::Request &req, httplib::Response &res) {
+        this->handleAdminReloadSettings(req, res);
+    });
     
     // for signin stuff
         svr.Get("/auth/google", [this](const httplib::Request &req, httplib::Response &res) {
@@ -445,6 +690,11 @@ void UrlShortenerServer::setupRoutes() {
         this->handleGoogleCallback(req, res);
     });
 
+    // POST /auth/logout - Revokes the bearer token
+    svr.Post("/auth/logout", [this](const httplib::Request &req, httplib::Response &res) {
+        this->handleLogout(req, res);
+    });
+
     // Mock success page to display the token after sign-in (SECURED WITH DB CHECK)
     svr.Get("/auth/success", [this](const httplib::Request &req, httplib::Response &res) {
         std::string token = req.get_param_value("token");
@@ -457,10 +707,8 @@ void UrlShortenerServer::setupRoutes() {
         }
 
         // === CHECK SESSION VALIDITY AGAINST DB ===
-        unique_lock<mutex> lock(dbMutex);
         // db.findSessionByToken returns nullptr if token is not found OR has expired.
         std::unique_ptr<Session> sessionObj = db.findSessionByToken(token);
-        lock.unlock();
 
         if (!sessionObj) {
             res.status = 401;
@@ -540,19 +788,36 @@ void UrlShortenerServer::setupRoutes() {
 
 // --- Route Handlers ---
 void UrlShortenerServer::handleShorten(const httplib::Request &req, httplib::Response &res) {
-    RequestContext ctx = get_context(res);
-    string longUrl = extractLongUrl(req.body);
+    const RequestContext& ctx = get_context();
+    JsonReader request(req.body);
+    if (!request.parse()) {
+        res.status = 400;
+        res.set_content(string("Malformed JSON body: ") + request.error() + ".", "text/plain");
+        return;
+    }
+    string scratch;
+    string longUrl(request.getString("long_url", scratch));
     string customCode = req.has_param("custom_code") ? req.get_param_value("custom_code") : "";
     string expiryDate = req.has_param("expires_at") ? req.get_param_value("expires_at") : "";
     string clientIp = req.remote_addr;
     
-    if (longUrl.empty() || longUrl.size() > Config::MAX_URL_LENGTH || 
-        (longUrl.compare(0, 7, "http://") != 0 && longUrl.compare(0, 8, "https://") != 0)) {
+    if (longUrl.empty()) {
         res.status = 400;
-        res.set_content(longUrl.empty() ? "Missing 'long_url' in request body." : "Invalid or too long URL.", "text/plain");
+        res.set_content("Missing 'long_url' in request body.", "text/plain");
         return;
     }
 
+    // Stored, cached and compared in canonical form only
+    string canonicalUrl;
+    canonicalUrl.reserve(longUrl.size() + 16);
+    UrlCanonicalizer::Result urlCheck = UrlCanonicalizer::canonicalize(longUrl, canonicalUrl, Config::MAX_URL_LENGTH);
+    if (urlCheck != UrlCanonicalizer::Result::Ok) {
+        res.status = 400;
+        res.set_content(string("Invalid URL: ") + UrlCanonicalizer::describe(urlCheck) + ".", "text/plain");
+        return;
+    }
+    longUrl = std::move(canonicalUrl);
+
 
     // --- Custom Code Restriction ---
     if (!customCode.empty() && !ctx.isAuthenticated) {
@@ -561,24 +826,66 @@ void UrlShortenerServer::handleShorten(const httplib::Request &req, httplib::Res
         return;
     }
 
-    // --- Rate Limiting ---
-    // Acquire the lock early to safely handle all DB-dependent checks (including getConfig)
-    // and the final link creation.
-    unique_lock<mutex> lock(dbMutex); 
+    // Prepare Link DTO (Authenticated Link Creation/Expiration)
+    ShortenedLink linkToSave;
+    linkToSave.original_url = longUrl;
+    linkToSave.url_hash = LinkDedupeIndex::hashUrl(longUrl);
+
+    if (ctx.isAuthenticated) {
+        linkToSave.user_id = make_unique<unsigned int>(ctx.userId); 
+        linkToSave.guest_identifier = "";
+    } else {
+        linkToSave.user_id = nullptr;
+        linkToSave.guest_identifier = clientIp;
+    }
     
+    // Link Expiration
+    linkToSave.expires_at = expiryDate!=""?expiryDate:"";
+
+    auto respond = [&](const string& code, int status, bool deduplicated) {
+        string fullShortUrl = Config::BASE_URL + code;
+        string body;
+        body.reserve(112 + fullShortUrl.size() + longUrl.size());
+        JsonWriter json(body);
+        json.beginObject()
+            .field("short_url", fullShortUrl)
+            .field("long_url", longUrl)
+            .field("authenticated", ctx.isAuthenticated)
+            .field("user_id", ctx.userId)
+            .field("deduplicated", deduplicated)
+            .endObject();
+
+        res.status = status;
+        res.set_content(std::move(body), "application/json");
+    };
+
+    // --- Dedupe (DEDUPE_LINKS) ---
+    // Only plain requests: a custom code or expiry asks for a distinct link.
+    // The lock is held until the new link is stored, so identical requests
+    // arriving together end up sharing one row; it covers only this owner and
+    // URL, so other shortens never queue behind the DB round-trip. A reused
+    // link costs no quota.
+    LinkDedupeIndex::KeyLock dedupeLock;
+    if (customCode.empty() && expiryDate.empty()) {
+        dedupeLock = db.lockLinkUrl(linkToSave);
+        if (auto existing = db.findDuplicateLink(linkToSave)) {
+            respond(existing->short_code, 200, true);
+            return;
+        }
+    }
+
+    // --- Rate Limiting ---
+    // Every DB call below is independently thread-safe; the guest quota is
+    // an in-memory compare-and-swap in GuestQuotaCounter.
     if (ctx.isAuthenticated) {
         if (!checkAndApplyUserLimit(ctx.userId)) { // Check authenticated user limit (Placeholder call)
-            lock.unlock(); // Must unlock before returning
             res.status = 429; // Too Many Requests
             res.set_content("Link creation limit (200/hr) reached. Please wait.", "text/plain");
             return;
         }
     } else {
-        // --- FIX: Get config value within the lock ---
-        string maxGuestLinks = db.getConfig( "MAX_GUEST_LINKS_PER_DAY");
-        
         if (!db.checkAndUpdateGuestQuota(clientIp, db.getTodayDate())) { // Check guest limit
-            lock.unlock(); // Must unlock before returning
+            string maxGuestLinks = std::to_string(db.getSettings()->maxGuestLinksPerDay);
             res.status = 403;
             res.set_content("Limit reached. Max "
                             + maxGuestLinks 
@@ -589,61 +896,51 @@ void UrlShortenerServer::handleShorten(const httplib::Request &req, httplib::Res
     }
     
     // --- 3. Determine Short Code & Conflict Handling ---
+    // Generated codes come from the id allocator and never collide with each
+    // other. The UNIQUE index on short_code still arbitrates against custom
+    // and legacy random codes: if createLink fails we retry with a fresh one.
+    const bool generated = customCode.empty();
+    const int MAX_CREATE_ATTEMPTS = generated ? 3 : 1;
     string shortCode = customCode;
-    if (shortCode.empty()) {
-        // Auto-generated code loop, handles conflict by retrying
-        do {
-            shortCode = generateShortCode();
-        } while (db.getLinkByShortCode(shortCode)); 
-    }
-    
-    // 3. Prepare Link DTO (Authenticated Link Creation/Expiration)
-    ShortenedLink linkToSave;
-    linkToSave.original_url = longUrl;
-    linkToSave.short_code = shortCode;
 
-    if (ctx.isAuthenticated) {
-        linkToSave.user_id = make_unique<unsigned int>(ctx.userId); 
-        linkToSave.guest_identifier = "";
-    } else {
-        linkToSave.user_id = nullptr;
-        linkToSave.guest_identifier = clientIp;
+    // Save Link
+    bool created = false;
+    for (int attempt = 0; attempt < MAX_CREATE_ATTEMPTS && !created; ++attempt) {
+        if (generated) {
+            if (codeReservoir) {
+                if (!codeReservoir->pop(shortCode)) shortCode.clear();
+            } else {
+                shortCode = codeAllocator.next();
+            }
+            if (shortCode.empty()) {
+                // Reservoir dry or no ids leased: fall back to probing random codes, handles conflict by retrying
+                do {
+                    shortCode = generateShortCode();
+                } while (db.getLinkByShortCode(shortCode));
+            }
+        }
+        linkToSave.short_code = shortCode;
+        created = linkBatcher ? linkBatcher->createLink(linkToSave) : db.createLink(linkToSave);
     }
-    
-    // Link Expiration
-    linkToSave.expires_at = expiryDate!=""?expiryDate:"";
-    
-    // Save Link (Protected by the lock acquired above)
-    if (!db.createLink(linkToSave)) {
-        lock.unlock();
+
+    if (!created) {
         res.status = 409; // Conflict
         res.set_content("Short code '" + shortCode + "' is already taken or DB error occurred.", "text/plain");
         return;
     }
-    lock.unlock(); // Release lock before responding
 
     // 5. Response
-    string fullShortUrl =  Config::BASE_URL + shortCode;
-    stringstream ss;
-    ss << "{ \"short_url\": \"" << fullShortUrl
-       << "\", \"long_url\": \"" << longUrl 
-       << "\", \"authenticated\": " << (ctx.isAuthenticated ? "true" : "false")
-       << ", \"user_id\": " << ctx.userId
-       << " }";
-
-    res.status = 201;
-    res.set_content(ss.str(), "application/json");
+    respond(shortCode, 201, false);
 }
 void UrlShortenerServer::handleRedirect(const httplib::Request &req, httplib::Response &res) {
     string code = req.matches[1];
     
-    unique_lock<mutex> lock(dbMutex);
     unique_ptr<ShortenedLink> link = db.getLinkByShortCode(code);
     
     if (link) {
         // Link Expiration Check is done inside getLinkByShortCode (WHERE expires_at > NOW())
-        // Link Analytics (Click Tracking)
-        db.incrementLinkClicks(link->id); 
+        // Link Analytics (Click Tracking), written to the DB in batches
+        clickCounter.record(link->id);
         
         // Redirect
         res.set_redirect(link->original_url);
@@ -655,7 +952,7 @@ void UrlShortenerServer::handleRedirect(const httplib::Request &req, httplib::Re
 
 // Implements Link Management Dashboard (Read All Links by User)
 void UrlShortenerServer::handleUserLinks(const httplib::Request &req, httplib::Response &res) {
-    RequestContext ctx = get_context(res);
+    const RequestContext& ctx = get_context();
 
     if (!ctx.isAuthenticated) {
         res.status = 401;
@@ -670,25 +967,142 @@ void UrlShortenerServer::handleUserLinks(const httplib::Request &req, httplib::R
         return;
     }
 
-    unique_lock<mutex> lock(dbMutex);
+    // ?stream=1: the whole list as one JSON array, sent in chunks while it is read
+    const string streamParam = req.get_param_value("stream");
+    if (streamParam == "1" || streamParam == "true") {
+        streamUserLinks(ctx.userId, res);
+        return;
+    }
+
+    // ?after=<created_at>,<id>&limit=<n>: one page plus the cursor of the next
+    if (req.has_param("after") || req.has_param("limit")) {
+        size_t limit = LINKS_PAGE_DEFAULT;
+        if (req.has_param("limit")) {
+            try {
+                limit = std::stoul(req.get_param_value("limit"));
+            } catch (const exception&) {
+                limit = 0;
+            }
+            if (limit == 0 || limit > LINKS_PAGE_MAX) {
+                res.status = 400;
+                res.set_content("Invalid limit, expected 1.." + std::to_string(LINKS_PAGE_MAX) + ".", "text/plain");
+                return;
+            }
+        }
+
+        LinkCursor after;
+        const bool hasAfter = req.has_param("after");
+        if (hasAfter && !parseLinkCursor(req.get_param_value("after"), after)) {
+            res.status = 400;
+            res.set_content("Invalid cursor, expected after=<created_at>,<id>.", "text/plain");
+            return;
+        }
+
+        // One row more than asked tells whether there is a next page
+        string body;
+        body.reserve(64 + limit * LINK_JSON_ESTIMATE);
+        JsonWriter json(body);
+        json.beginObject().key("links").beginArray();
+        size_t count = 0;
+        LinkCursor last;
+        bool more = false;
+        bool ok = db.forEachUserLink(ctx.userId, hasAfter ? &after : nullptr, limit + 1, [&](const ShortenedLink& link) {
+            if (count == limit) {
+                more = true;
+                return false;
+            }
+            appendLinkJson(json, link);
+            last.created_at = link.created_at;
+            last.id = link.id;
+            ++count;
+            return true;
+        });
+        if (!ok) {
+            res.status = 500;
+            res.set_content("Failed to load links.", "text/plain");
+            return;
+        }
+        json.endArray().key("next");
+        if (more) {
+            json.value(last.created_at + "," + std::to_string(last.id));
+        } else {
+            json.null();
+        }
+        json.endObject();
+
+        res.status = 200;
+        res.set_content(std::move(body), "application/json");
+        return;
+    }
+
     unique_ptr<vector<ShortenedLink>> links = db.getLinksByUserId(ctx.userId);
     
     // Convert links vector to a JSON array string for response
-    stringstream ss;
-    ss << "[";
-    bool first = true;
+    string body;
+    body.reserve(2 + links->size() * LINK_JSON_ESTIMATE);
+    JsonWriter json(body);
+    json.beginArray();
     for (const auto& link : *links) {
-        if (!first) ss << ",";
-        ss << "{\"code\":\"" << link.short_code << "\",";
-        ss << "\"url\":\"" << link.original_url << "\",";
-        ss << "\"clicks\":" << link.clicks << ","; // Link Analytics
-        ss << "\"expires_at\":\"" << link.expires_at << "\"}";
-        first = false;
+        appendLinkJson(json, link);
     }
-    ss << "]";
+    json.endArray();
+
+    res.status = 200;
+    res.set_content(std::move(body), "application/json");
+}
+
+// Chunked /api/links: each chunk is one keyset page, read and serialized
+// before the session goes back to the pool, so a slow client never holds a
+// DB session and memory stays at one page however many links there are.
+void UrlShortenerServer::streamUserLinks(unsigned int userId, httplib::Response &res) {
+    struct StreamState {
+        LinkCursor cursor;
+        bool hasCursor = false;
+        bool anyRow = false;
+        bool opened = false;
+        bool done = false;
+        string chunk; // Reused for every page, keeps its capacity
+    };
+    auto state = std::make_shared<StreamState>();
 
     res.status = 200;
-    res.set_content(ss.str(), "application/json");
+    res.set_chunked_content_provider("application/json", [this, userId, state](size_t, httplib::DataSink& sink) {
+        string& chunk = state->chunk;
+        chunk.clear();
+        if (!state->opened) {
+            chunk.reserve(2 + LINKS_STREAM_PAGE * LINK_JSON_ESTIMATE);
+            chunk += '[';
+            state->opened = true;
+        }
+
+        size_t rows = 0;
+        bool ok = db.forEachUserLink(userId, state->hasCursor ? &state->cursor : nullptr, LINKS_STREAM_PAGE,
+                                     [&](const ShortenedLink& link) {
+            // Elements continue the array across chunks, so commas are placed here
+            if (state->anyRow) chunk += ',';
+            state->anyRow = true;
+            JsonWriter json(chunk);
+            appendLinkJson(json, link);
+            state->cursor.created_at = link.created_at;
+            state->cursor.id = link.id;
+            state->hasCursor = true;
+            ++rows;
+            return true;
+        });
+        if (!ok) {
+            // Headers are already sent: cut the connection so the client sees an incomplete body
+            cerr << "DB_ERROR: Streaming links for user " << userId << " failed." << endl;
+            return false;
+        }
+
+        if (rows < LINKS_STREAM_PAGE) {
+            chunk += ']';
+            state->done = true;
+        }
+        if (!sink.write(chunk.data(), chunk.size())) return false;
+        if (state->done) sink.done();
+        return true;
+    });
 }
 
 
@@ -797,8 +1211,12 @@ void UrlShortenerServer::handleGoogleCallback(const httplib::Request &req, httpl
         }
 
         // Parse the JSON response for tokens
-        std::string id_token = getJsonValue(token_res->body, "id_token");
-        std::string access_token = getJsonValue(token_res->body, "access_token");
+        JsonReader tokenJson(token_res->body);
+        if (!tokenJson.parse()) {
+            std::cerr << "SERVER_ERROR: Token response is not valid JSON (" << tokenJson.error() << " at byte " << tokenJson.errorOffset() << ")." << std::endl;
+        }
+        std::string id_token = tokenJson.getString("id_token");
+        std::string access_token = tokenJson.getString("access_token");
         std::cerr << "SERVER_DEBUG: Tokens extracted. ID Token start: " << id_token.substr(0, 10) << "..." << std::endl; // LOG SUCCESS
 
         if (id_token.empty() || access_token.empty()) {
@@ -825,9 +1243,13 @@ void UrlShortenerServer::handleGoogleCallback(const httplib::Request &req, httpl
         }
 
         // Extract user data (simplified JSON parsing)
-        std::string email = getJsonValue(user_info_res->body, "email");
-        std::string name = getJsonValue(user_info_res->body, "name");
-        std::string google_id = getJsonValue(user_info_res->body, "sub"); // 'sub' is the unique Google ID
+        JsonReader userJson(user_info_res->body);
+        if (!userJson.parse()) {
+            std::cerr << "SERVER_ERROR: User info is not valid JSON (" << userJson.error() << " at byte " << userJson.errorOffset() << ")." << std::endl;
+        }
+        std::string email = userJson.getString("email");
+        std::string name = userJson.getString("name");
+        std::string google_id = userJson.getString("sub"); // 'sub' is the unique Google ID
         std::cerr << "SERVER_DEBUG: User Info received for: " << email << std::endl; // LOG USER DATA
 
         if (email.empty() || name.empty() || google_id.empty()) {
@@ -838,8 +1260,6 @@ void UrlShortenerServer::handleGoogleCallback(const httplib::Request &req, httpl
         }
 
         // Create/Find User and Create Session
-        unique_lock<mutex> lock(dbMutex);
-        
         unique_ptr<User> existingUser = db.findUserByEmail(email);
         unsigned int userId;
 
@@ -849,10 +1269,12 @@ void UrlShortenerServer::handleGoogleCallback(const httplib::Request &req, httpl
             newUser.google_id = google_id;
             newUser.email = email;
             newUser.name = name;
-            if (db.createUser(newUser)) {
-                // Re-fetch the user to get the auto-generated ID
-                existingUser = db.findUserByEmail(email); 
+            if (!db.createUser(newUser)) {
+                // A concurrent sign-in may have created the same user first
+                std::cerr << "SERVER_INFO: createUser failed, re-checking for a concurrently created user." << std::endl;
             }
+            // Re-fetch the user to get the auto-generated ID
+            existingUser = db.findUserByEmail(email); 
         }
         
         if (!existingUser) {
@@ -863,12 +1285,14 @@ void UrlShortenerServer::handleGoogleCallback(const httplib::Request &req, httpl
         }
 
         userId = existingUser->id;
-        std::string token = createSessionToken(userId, email);
+        // One expiry for the token and its row, so a revoked token stays listed for as long as it verifies
+        const std::time_t sessionExpires = std::time(nullptr) + std::time_t(SESSION_LIFETIME_DAYS) * 24 * 60 * 60;
+        std::string token = createSessionToken(userId, email, sessionExpires);
 
         Session sessionObj;
         sessionObj.user_id = userId;
         sessionObj.session_token = token;
-        sessionObj.expires_at = db.getFutureTimestamp(30); // 30 days expiration
+        sessionObj.expires_at = UrlShortenerDB::formatTimestamp(sessionExpires);
 
         if (!db.createSession(sessionObj)) {
             std::cerr << "DB_ERROR: Failed to create session for user " << userId << std::endl;
@@ -4,9 +4,19 @@
 #include <iostream>
 #include <mutex>
 #include <string>
+#include <string_view>
 
 #include "URLShortnerDB.h"
 #include "Config.h"
+#include "ClickCounter.h"
+#include "EndpointStats.h"
+#include "RateLimiter.h"
+#include "SessionToken.h"
+#include "RevocationList.h"
+#include "Logger.h"
+#include "ShortCodeAllocator.h"
+#include "CodeReservoir.h"
+#include "LinkBatcher.h"
 
 #include "Modals/SessionDTO.h"
 
@@ -14,20 +24,49 @@
 struct RequestContext {
     bool isAuthenticated = false;
     unsigned int userId = 0; // 0 for unauthenticated
-    std::string userRole = "guest";
+    std::string_view userRole = "guest"; // Always one of the string literals "guest", "user", "admin"
 };
 
 class UrlShortenerServer {
 public:
-    UrlShortenerServer(UrlShortenerDB& db_instance, std::mutex& db_mutex_ref);
+    explicit UrlShortenerServer(UrlShortenerDB& db_instance);
 
     // Runs the server
     bool run();
 
+    // Stops listening; run() returns once in-flight requests are done
+    void stop();
+
 private:
+    static thread_local RequestContext requestContext;
+
     httplib::Server svr;
-    UrlShortenerDB& db;
-    std::mutex& dbMutex;
+    UrlShortenerDB& db; // Thread-safe, shared by all handler threads
+
+    // Asynchronous request log (stderr + sampled Sentry)
+    SaveLogs requestLog;
+
+    // Buffered click tracking, flushed in batches (and on shutdown)
+    ClickCounter clickCounter;
+
+    // Per-thread endpoint counters, upserted in batches
+    EndpointStats endpointStats;
+
+    // Per-client token buckets, bounded to RATE_LIMIT_MAX_CLIENTS
+    RateLimiter rateLimiter;
+
+    // Signed session tokens verified without the DB (opt-in via SESSION_TOKEN_KEYS)
+    SessionTokenSigner tokenSigner;
+    std::unique_ptr<RevocationList> revokedTokens; // Only when tokenSigner is enabled
+
+    // Collision-free short codes from block-leased ids
+    ShortCodeAllocator codeAllocator;
+
+    // Pre-validated random codes (SHORT_CODE_STRATEGY=random, or no SHORT_CODE_SCRAMBLE_KEY)
+    std::unique_ptr<CodeReservoir> codeReservoir;
+
+    // Group commit for link creation (only when LINK_GROUP_COMMIT_WINDOW_MS > 0)
+    std::unique_ptr<LinkBatcher> linkBatcher;
     
     // --- Middleware ---
     void setupMiddleware();
@@ -36,17 +75,20 @@ private:
     httplib::Server::HandlerResponse AuthMiddleware(const httplib::Request &req, httplib::Response &res);
 
     // --- Utility ---
-    static void set_context(httplib::Response &res, const RequestContext &ctx);
-    static RequestContext get_context(const httplib::Response &res);
+    // Context of the request being handled on this thread. httplib runs the
+    // pre-routing handler and the route handler on the same worker thread,
+    // and AuthMiddleware resets it at the start of every request.
+    static void set_context(const RequestContext &ctx);
+    static const RequestContext& get_context();
     bool checkAndApplyRateLimitDB(const std::string &guestId);
     static std::string generateShortCode(size_t length = 8);
-    static std::string extractLongUrl(const std::string &body);
     void handleLinkFavorite(const httplib::Request &req, httplib::Response &res);
-    bool checkUserRole(const RequestContext &ctx, const std::string &requiredRole);
+    bool checkUserRole(const RequestContext &ctx, std::string_view requiredRole);
     bool checkAndApplyUserLimit(unsigned int userId);
     void handleLinkDelete(const httplib::Request &req, httplib::Response &res);
     void handleAdminTest(const httplib::Request &req, httplib::Response &res);
-    std::string extractShortUrl(const std::string &body);
+    void handleAdminStats(const httplib::Request &req, httplib::Response &res);
+    void handleAdminReloadSettings(const httplib::Request &req, httplib::Response &res);
     httplib::Server::HandlerResponse EndpointStatMiddleware(const httplib::Request &req, httplib::Response &res);
     // --- Routes ---
     void setupRoutes();
@@ -56,12 +98,13 @@ private:
     
     // Link Management Dashboard
     void handleUserLinks(const httplib::Request &req, httplib::Response &res);
+    void streamUserLinks(unsigned int userId, httplib::Response &res);
 
     // --- google sign in ---
     std::string generateRandomState(size_t length);
     void handleGoogleRedirect(const httplib::Request &req, httplib::Response &res);
-    std::string createSessionToken(unsigned int userId, const std::string& email);
-
-     // Internal helper for JSON parsing (Simplification for no external JSON library)
-    std::string getJsonValue(const std::string& json, const std::string& key);
+    // Signed tokens carry `expires`, which must match the session row's expires_at
+    std::string createSessionToken(unsigned int userId, const std::string& email, std::time_t expires);
+    static constexpr int SESSION_LIFETIME_DAYS = 30;
+    void handleLogout(const httplib::Request &req, httplib::Response &res);
 };
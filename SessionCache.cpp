@@ -0,0 +1,106 @@
+#include "SessionCache.h"
+
+#include <algorithm>
+#include <functional>
+
+using std::lock_guard;
+using std::mutex;
+using std::shared_ptr;
+using std::string;
+
+SessionCache::SessionCache(size_t capacity, std::time_t maxAgeSeconds, std::time_t negativeTtlSeconds, size_t shardCount)
+    : maxAge(maxAgeSeconds), negativeTtl(negativeTtlSeconds) {
+    if (shardCount == 0) shardCount = 1;
+    shards.reserve(shardCount);
+    for (size_t i = 0; i < shardCount; ++i) {
+        shards.push_back(std::make_unique<Shard>());
+    }
+    // Round up so the total never drops below the requested capacity
+    shardCapacity = (capacity + shardCount - 1) / shardCount;
+    if (shardCapacity == 0) shardCapacity = 1;
+}
+
+SessionCache::Shard& SessionCache::shardFor(const string& token) {
+    return *shards[std::hash<string>{}(token) % shards.size()];
+}
+
+bool SessionCache::lookup(const string& token, shared_ptr<const CachedSession>& session) {
+    Shard& shard = shardFor(token);
+    lock_guard<mutex> lock(shard.mutex);
+
+    auto it = shard.index.find(token);
+    if (it == shard.index.end()) {
+        missCount.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    // Token Expiration: a session (or negative entry) is gone once its time is up
+    if (it->second->evictAt <= std::time(nullptr)) {
+        shard.lru.erase(it->second);
+        shard.index.erase(it);
+        missCount.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    shard.lru.splice(shard.lru.begin(), shard.lru, it->second);
+    session = it->second->session;
+    if (session) {
+        hitCount.fetch_add(1, std::memory_order_relaxed);
+    } else {
+        negativeHitCount.fetch_add(1, std::memory_order_relaxed);
+    }
+    return true;
+}
+
+void SessionCache::put(const string& token, CachedSession session) {
+    std::time_t evictAt = std::time(nullptr) + maxAge;
+    if (session.expires_epoch != 0) evictAt = std::min(evictAt, session.expires_epoch);
+    insert(token, std::make_shared<const CachedSession>(std::move(session)), evictAt);
+}
+
+void SessionCache::putInvalid(const string& token) {
+    if (negativeTtl <= 0) return;
+    insert(token, nullptr, std::time(nullptr) + negativeTtl);
+}
+
+void SessionCache::insert(const string& token, shared_ptr<const CachedSession> session, std::time_t evictAt) {
+    Shard& shard = shardFor(token);
+    lock_guard<mutex> lock(shard.mutex);
+
+    auto it = shard.index.find(token);
+    if (it != shard.index.end()) {
+        it->second->session = std::move(session);
+        it->second->evictAt = evictAt;
+        shard.lru.splice(shard.lru.begin(), shard.lru, it->second);
+        return;
+    }
+
+    shard.lru.push_front(Entry{token, std::move(session), evictAt});
+    shard.index.emplace(token, shard.lru.begin());
+
+    // Evict the least recently used entry once the shard is full
+    if (shard.lru.size() > shardCapacity) {
+        shard.index.erase(shard.lru.back().token);
+        shard.lru.pop_back();
+    }
+}
+
+void SessionCache::invalidate(const string& token) {
+    Shard& shard = shardFor(token);
+    lock_guard<mutex> lock(shard.mutex);
+
+    auto it = shard.index.find(token);
+    if (it != shard.index.end()) {
+        shard.lru.erase(it->second);
+        shard.index.erase(it);
+    }
+}
+
+size_t SessionCache::size() const {
+    size_t total = 0;
+    for (const auto& shard : shards) {
+        lock_guard<mutex> lock(shard->mutex);
+        total += shard->lru.size();
+    }
+    return total;
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <atomic>
+#include <ctime>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Resolved session as kept by the token cache
+struct CachedSession {
+    unsigned int id = 0;
+    unsigned int user_id = 0;
+    std::string expires_at;         // Same text as the DB column (YYYY-MM-DD HH:MM:SS)
+    std::time_t expires_epoch = 0;
+};
+
+// Bounded, sharded LRU cache of session_token -> session, including
+// known-bad tokens so repeated bogus tokens do not reach MySQL.
+//
+// Valid sessions are evicted at their expires_at (or after maxAge, whichever
+// comes first, so a logout on another instance is picked up eventually);
+// unknown tokens are remembered for negativeTtl seconds.
+class SessionCache {
+public:
+    SessionCache(size_t capacity, std::time_t maxAge, std::time_t negativeTtl, size_t shardCount = 16);
+
+    // True if the cache has an answer for the token. `session` is then the
+    // cached session, or nullptr for a token known to be invalid.
+    bool lookup(const std::string& token, std::shared_ptr<const CachedSession>& session);
+    void put(const std::string& token, CachedSession session);
+    void putInvalid(const std::string& token);
+    void invalidate(const std::string& token);
+
+    size_t capacity() const { return shardCapacity * shards.size(); }
+    size_t size() const;
+    unsigned long long hits() const { return hitCount.load(std::memory_order_relaxed); }
+    unsigned long long negativeHits() const { return negativeHitCount.load(std::memory_order_relaxed); }
+    unsigned long long misses() const { return missCount.load(std::memory_order_relaxed); }
+
+private:
+    struct Entry {
+        std::string token;
+        std::shared_ptr<const CachedSession> session; // nullptr = invalid token
+        std::time_t evictAt;
+    };
+
+    struct Shard {
+        mutable std::mutex mutex;
+        std::list<Entry> lru; // front = most recently used
+        std::unordered_map<std::string, std::list<Entry>::iterator> index;
+    };
+
+    Shard& shardFor(const std::string& token);
+    void insert(const std::string& token, std::shared_ptr<const CachedSession> session, std::time_t evictAt);
+
+    std::vector<std::unique_ptr<Shard>> shards;
+    size_t shardCapacity;
+    std::time_t maxAge;
+    std::time_t negativeTtl;
+    std::atomic<unsigned long long> hitCount{0};
+    std::atomic<unsigned long long> negativeHitCount{0};
+    std::atomic<unsigned long long> missCount{0};
+};
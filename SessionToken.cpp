@@ -0,0 +1,134 @@
+#include "SessionToken.h"
+
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+
+#include <openssl/crypto.h>
+#include <openssl/evp.h>
+#include <openssl/hmac.h>
+
+using std::cerr;
+using std::endl;
+using std::string;
+
+namespace {
+
+string base64UrlEncode(const unsigned char* data, size_t length) {
+    static const char ALPHABET[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_";
+    string out;
+    out.reserve((length * 4 + 2) / 3);
+    size_t i = 0;
+    for (; i + 2 < length; i += 3) {
+        uint32_t chunk = (uint32_t(data[i]) << 16) | (uint32_t(data[i + 1]) << 8) | data[i + 2];
+        out += ALPHABET[(chunk >> 18) & 63];
+        out += ALPHABET[(chunk >> 12) & 63];
+        out += ALPHABET[(chunk >> 6) & 63];
+        out += ALPHABET[chunk & 63];
+    }
+    // Unpadded tail
+    if (i < length) {
+        uint32_t chunk = uint32_t(data[i]) << 16;
+        if (i + 1 < length) chunk |= uint32_t(data[i + 1]) << 8;
+        out += ALPHABET[(chunk >> 18) & 63];
+        out += ALPHABET[(chunk >> 12) & 63];
+        if (i + 1 < length) out += ALPHABET[(chunk >> 6) & 63];
+    }
+    return out;
+}
+
+bool parseUnsigned(const string& text, unsigned long long& value) {
+    if (text.empty() || text.size() > 20) return false;
+    value = 0;
+    for (char c : text) {
+        if (c < '0' || c > '9') return false;
+        value = value * 10 + static_cast<unsigned>(c - '0');
+    }
+    return true;
+}
+
+} // namespace
+
+SessionTokenSigner::SessionTokenSigner(const string& keySpec, const string& active) : activeKid(active) {
+    std::stringstream ss(keySpec);
+    string entry;
+    while (std::getline(ss, entry, ',')) {
+        size_t colon = entry.find(':');
+        if (colon == string::npos || colon == 0 || colon + 1 == entry.size()) {
+            cerr << "CONFIG_WARN: Ignoring malformed session token key entry." << endl;
+            continue;
+        }
+        string kid = entry.substr(0, colon);
+        if (kid.find('.') != string::npos) {
+            cerr << "CONFIG_WARN: Session token key id '" << kid << "' must not contain '.', ignored." << endl;
+            continue;
+        }
+        keys[kid] = entry.substr(colon + 1);
+    }
+
+    if (keys.empty()) return;
+    auto it = keys.find(activeKid);
+    if (it == keys.end()) {
+        cerr << "CONFIG_WARN: Active session token key '" << activeKid << "' is not configured, signed tokens disabled." << endl;
+        return;
+    }
+    activeSecret = it->second;
+}
+
+string SessionTokenSigner::mac(const string& secret, const string& signedPart) const {
+    unsigned char digest[EVP_MAX_MD_SIZE];
+    unsigned int digestLength = 0;
+    HMAC(EVP_sha256(), secret.data(), static_cast<int>(secret.size()),
+         reinterpret_cast<const unsigned char*>(signedPart.data()), signedPart.size(), digest, &digestLength);
+    return base64UrlEncode(digest, digestLength);
+}
+
+string SessionTokenSigner::issue(const TokenClaims& claims, const string& nonce) const {
+    string signedPart = "v1." + activeKid + "." + std::to_string(claims.userId) + (claims.isAdmin ? "-a-" : "-u-") +
+                        std::to_string(static_cast<long long>(claims.expires)) + "-" + nonce;
+    return signedPart + "." + mac(activeSecret, signedPart);
+}
+
+bool SessionTokenSigner::verify(const string& token, TokenClaims& claims) const {
+    if (!isSignedToken(token)) return false;
+
+    size_t kidEnd = token.find('.', 3);
+    size_t macStart = token.rfind('.');
+    if (kidEnd == string::npos || macStart <= kidEnd) return false;
+
+    auto key = keys.find(token.substr(3, kidEnd - 3));
+    if (key == keys.end()) return false; // Unknown or retired key
+
+    string signedPart = token.substr(0, macStart);
+    string expected = mac(key->second, signedPart);
+    size_t macLength = token.size() - macStart - 1;
+    if (macLength != expected.size() ||
+        CRYPTO_memcmp(expected.data(), token.data() + macStart + 1, macLength) != 0) {
+        return false;
+    }
+
+    // The MAC is good, so the payload is ours: <userId>-<u|a>-<expires>-<nonce>
+    string payload = signedPart.substr(kidEnd + 1);
+    size_t first = payload.find('-');
+    size_t second = first == string::npos ? string::npos : payload.find('-', first + 1);
+    size_t third = second == string::npos ? string::npos : payload.find('-', second + 1);
+    if (third == string::npos) return false;
+
+    unsigned long long userId = 0;
+    unsigned long long expires = 0;
+    string role = payload.substr(first + 1, second - first - 1);
+    if (!parseUnsigned(payload.substr(0, first), userId) ||
+        !parseUnsigned(payload.substr(second + 1, third - second - 1), expires) ||
+        (role != "u" && role != "a")) {
+        return false;
+    }
+
+    // Token Expiration Check
+    if (static_cast<std::time_t>(expires) <= std::time(nullptr)) return false;
+
+    claims.userId = static_cast<unsigned int>(userId);
+    claims.isAdmin = role == "a";
+    claims.expires = static_cast<std::time_t>(expires);
+    return true;
+}
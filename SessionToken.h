@@ -0,0 +1,45 @@
+#pragma once
+
+#include <ctime>
+#include <string>
+#include <unordered_map>
+
+// Claims carried by a signed session token
+struct TokenClaims {
+    unsigned int userId = 0;
+    bool isAdmin = false;
+    std::time_t expires = 0;
+};
+
+// Issues and verifies self-contained session tokens of the form
+//
+//     v1.<kid>.<userId>-<u|a>-<expires>-<nonce>.<mac>
+//
+// where mac is the base64url HMAC-SHA256 of everything before the last dot,
+// under the key named by kid. Several keys can be configured so a key can be
+// rotated out: new tokens use the active key, and tokens signed with any
+// configured key verify until they expire.
+//
+// Keys come as "kid:secret,kid:secret"; an empty spec disables signed tokens.
+class SessionTokenSigner {
+public:
+    SessionTokenSigner(const std::string& keySpec, const std::string& activeKid);
+
+    bool enabled() const { return !activeSecret.empty(); }
+
+    // Cheap prefix check, tells signed tokens apart from legacy opaque ones
+    static bool isSignedToken(const std::string& token) { return token.rfind("v1.", 0) == 0; }
+
+    // Requires enabled()
+    std::string issue(const TokenClaims& claims, const std::string& nonce) const;
+
+    // True if the MAC checks out under a known key and the token has not expired
+    bool verify(const std::string& token, TokenClaims& claims) const;
+
+private:
+    std::string mac(const std::string& secret, const std::string& signedPart) const;
+
+    std::unordered_map<std::string, std::string> keys; // kid -> secret
+    std::string activeKid;
+    std::string activeSecret;
+};
@@ -0,0 +1,118 @@
+#include "ShortCodeAllocator.h"
+#include "URLShortnerDB.h"
+
+#include <iostream>
+
+using std::cerr;
+using std::endl;
+using std::lock_guard;
+using std::string;
+
+namespace {
+
+const char BASE62[] = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz";
+const uint64_t CODE_SPACE = 218340105584896ULL; // 62^8
+const uint64_t HALF_MASK = (1ULL << 24) - 1;    // Feistel works on 2 x 24 bits (2^48 > 62^8)
+const int FEISTEL_ROUNDS = 4;
+
+uint64_t roundFunction(uint64_t half, uint64_t key, int round) {
+    uint64_t x = half ^ (key + 0x9E3779B97F4A7C15ULL * static_cast<uint64_t>(round + 1));
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return x & HALF_MASK;
+}
+
+uint64_t feistel(uint64_t value, uint64_t key) {
+    uint64_t left = value >> 24, right = value & HALF_MASK;
+    for (int round = 0; round < FEISTEL_ROUNDS; ++round) {
+        uint64_t next = left ^ roundFunction(right, key, round);
+        left = right;
+        right = next;
+    }
+    return (left << 24) | right;
+}
+
+uint64_t feistelInverse(uint64_t value, uint64_t key) {
+    uint64_t left = value >> 24, right = value & HALF_MASK;
+    for (int round = FEISTEL_ROUNDS - 1; round >= 0; --round) {
+        uint64_t previous = right ^ roundFunction(left, key, round);
+        right = left;
+        left = previous;
+    }
+    return (left << 24) | right;
+}
+
+// Cycle-walking keeps the 2^48 permutation inside [0, 62^8)
+uint64_t permute(uint64_t value, uint64_t key) {
+    do {
+        value = feistel(value, key);
+    } while (value >= CODE_SPACE);
+    return value;
+}
+
+uint64_t unpermute(uint64_t value, uint64_t key) {
+    do {
+        value = feistelInverse(value, key);
+    } while (value >= CODE_SPACE);
+    return value;
+}
+
+int base62Digit(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'A' && c <= 'Z') return c - 'A' + 10;
+    if (c >= 'a' && c <= 'z') return c - 'a' + 36;
+    return -1;
+}
+
+} // namespace
+
+ShortCodeAllocator::ShortCodeAllocator(UrlShortenerDB& db_instance, uint64_t block, uint64_t key)
+    : db(db_instance), blockSize(block == 0 ? 1 : block), scrambleKey(key) {
+}
+
+string ShortCodeAllocator::encode(uint64_t id, uint64_t key) {
+    uint64_t value = key != 0 ? permute(id % CODE_SPACE, key) : id % CODE_SPACE;
+
+    string code(CODE_LENGTH, '0');
+    for (size_t i = CODE_LENGTH; i-- > 0;) {
+        code[i] = BASE62[value % 62];
+        value /= 62;
+    }
+    return code;
+}
+
+uint64_t ShortCodeAllocator::decode(const string& code, uint64_t key) {
+    if (code.size() != CODE_LENGTH) return 0;
+
+    uint64_t value = 0;
+    for (char c : code) {
+        int digit = base62Digit(c);
+        if (digit < 0) return 0;
+        value = value * 62 + static_cast<uint64_t>(digit);
+    }
+    return key != 0 ? unpermute(value, key) : value;
+}
+
+string ShortCodeAllocator::next() {
+    lock_guard<std::mutex> lock(mutex);
+
+    if (nextId >= endId) {
+        // One round-trip per block; other creators wait only on this rare path
+        uint64_t first = db.leaseIdBlock("short_code", blockSize);
+        if (first == 0) {
+            cerr << "ALLOCATOR_ERROR: Failed to lease a block of short code ids." << endl;
+            return "";
+        }
+        nextId = first;
+        endId = first + blockSize;
+    }
+
+    if (nextId >= CODE_SPACE) {
+        cerr << "ALLOCATOR_ERROR: Short code id space exhausted." << endl;
+        return "";
+    }
+    return encode(nextId++, scrambleKey);
+}
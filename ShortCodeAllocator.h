@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+class UrlShortenerDB;
+
+// Collision-free short code allocator.
+//
+// Each process leases blocks of numeric ids from the id_sequences row in
+// MySQL (one round-trip per block) and hands them out locally, so creating
+// a link needs no collision probe and two processes can never produce the
+// same code. Ids are encoded as fixed-length base62; with a non-zero
+// scramble key they first go through a keyed, reversible permutation of the
+// 62^8 code space so consecutive codes are not guessable.
+class ShortCodeAllocator {
+public:
+    static constexpr size_t CODE_LENGTH = 8;
+
+    ShortCodeAllocator(UrlShortenerDB& db, uint64_t blockSize, uint64_t scrambleKey);
+
+    // Next unused code, or "" if a new block could not be leased
+    std::string next();
+
+    // Bijective id <-> code mapping (decode returns 0 for invalid codes)
+    static std::string encode(uint64_t id, uint64_t scrambleKey);
+    static uint64_t decode(const std::string& code, uint64_t scrambleKey);
+
+private:
+    UrlShortenerDB& db;
+    uint64_t blockSize;
+    uint64_t scrambleKey;
+
+    std::mutex mutex;
+    uint64_t nextId = 0; // Next id to hand out from the current block
+    uint64_t endId = 0;  // One past the last id of the current block
+};
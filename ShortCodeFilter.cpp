@@ -0,0 +1,105 @@
+#include "ShortCodeFilter.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// FNV-1a followed by a splitmix64 finalizer; two halves feed double hashing
+uint64_t hashCode(const std::string& code) {
+    uint64_t hash = 1469598103934665603ULL;
+    for (unsigned char c : code) {
+        hash ^= c;
+        hash *= 1099511628211ULL;
+    }
+    hash ^= hash >> 30;
+    hash *= 0xbf58476d1ce4e5b9ULL;
+    hash ^= hash >> 27;
+    hash *= 0x94d049bb133111ebULL;
+    hash ^= hash >> 31;
+    return hash;
+}
+
+const uint8_t COUNTER_MAX = 255; // Saturated counters are never decremented
+
+} // namespace
+
+ShortCodeFilter::ShortCodeFilter(size_t expectedItems, double targetFalsePositiveRate) {
+    const double ln2 = std::log(2.0);
+    if (expectedItems == 0) expectedItems = 1;
+    if (targetFalsePositiveRate <= 0.0 || targetFalsePositiveRate >= 1.0) targetFalsePositiveRate = 0.01;
+
+    // Standard sizing: m = -n ln(p) / ln(2)^2, k = (m / n) ln(2)
+    double m = -static_cast<double>(expectedItems) * std::log(targetFalsePositiveRate) / (ln2 * ln2);
+    counterCount = std::max<size_t>(64, static_cast<size_t>(std::ceil(m)));
+    double k = (static_cast<double>(counterCount) / expectedItems) * ln2;
+    hashCount = std::min<size_t>(MAX_HASHES, std::max<size_t>(1, static_cast<size_t>(std::round(k))));
+
+    counters.reset(new std::atomic<uint8_t>[counterCount]);
+    for (size_t i = 0; i < counterCount; ++i) {
+        counters[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+void ShortCodeFilter::indexes(const std::string& code, size_t* out) const {
+    uint64_t hash = hashCode(code);
+    uint64_t h1 = hash & 0xffffffffULL;
+    uint64_t h2 = (hash >> 32) | 1; // Odd step so probes never collapse
+    for (size_t i = 0; i < hashCount; ++i) {
+        out[i] = static_cast<size_t>((h1 + i * h2) % counterCount);
+    }
+}
+
+void ShortCodeFilter::add(const std::string& code) {
+    size_t idx[MAX_HASHES];
+    indexes(code, idx);
+    for (size_t i = 0; i < hashCount; ++i) {
+        auto& counter = counters[idx[i]];
+        uint8_t current = counter.load(std::memory_order_relaxed);
+        while (current != COUNTER_MAX &&
+               !counter.compare_exchange_weak(current, current + 1, std::memory_order_relaxed)) {
+        }
+    }
+    items.fetch_add(1, std::memory_order_relaxed);
+}
+
+void ShortCodeFilter::remove(const std::string& code) {
+    // Removing before the initial load is complete could clear counters that
+    // belong to codes not loaded yet, so keep the (safe) stale positive instead.
+    if (!isReady()) return;
+
+    size_t idx[MAX_HASHES];
+    indexes(code, idx);
+    for (size_t i = 0; i < hashCount; ++i) {
+        auto& counter = counters[idx[i]];
+        uint8_t current = counter.load(std::memory_order_relaxed);
+        while (current != 0 && current != COUNTER_MAX &&
+               !counter.compare_exchange_weak(current, current - 1, std::memory_order_relaxed)) {
+        }
+    }
+
+    size_t current = items.load(std::memory_order_relaxed);
+    while (current != 0 && !items.compare_exchange_weak(current, current - 1, std::memory_order_relaxed)) {
+    }
+}
+
+bool ShortCodeFilter::mightContain(const std::string& code) const {
+    if (!isReady()) return true;
+
+    size_t idx[MAX_HASHES];
+    indexes(code, idx);
+    for (size_t i = 0; i < hashCount; ++i) {
+        if (counters[idx[i]].load(std::memory_order_relaxed) == 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+double ShortCodeFilter::falsePositiveRate() const {
+    // (1 - e^(-k n / m))^k
+    double n = static_cast<double>(itemCount());
+    double k = static_cast<double>(hashCount);
+    double m = static_cast<double>(counterCount);
+    return std::pow(1.0 - std::exp(-k * n / m), k);
+}
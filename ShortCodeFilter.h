@@ -0,0 +1,44 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+// Counting Bloom filter over all live short codes.
+//
+// mightContain() == false means the code definitely does not exist, so
+// scans of random /<code> paths and most short code generation attempts can
+// skip MySQL entirely. Counters (8-bit, saturating) make remove() possible
+// when a link is deleted.
+//
+// Until markReady() is called (i.e. while the filter is still being loaded
+// from shortened_links) every lookup answers "maybe" and removals are ignored,
+// so a half-built filter can only produce false positives, never false negatives.
+class ShortCodeFilter {
+public:
+    ShortCodeFilter(size_t expectedItems, double targetFalsePositiveRate);
+
+    void add(const std::string& code);
+    void remove(const std::string& code);
+    bool mightContain(const std::string& code) const;
+
+    void markReady() { ready.store(true, std::memory_order_release); }
+    bool isReady() const { return ready.load(std::memory_order_acquire); }
+
+    size_t itemCount() const { return items.load(std::memory_order_relaxed); }
+    size_t memoryBytes() const { return counterCount * sizeof(std::atomic<uint8_t>); }
+    // Expected false-positive rate for the current number of items
+    double falsePositiveRate() const;
+
+private:
+    void indexes(const std::string& code, size_t* out) const;
+
+    static constexpr size_t MAX_HASHES = 16;
+
+    size_t counterCount;
+    size_t hashCount;
+    std::unique_ptr<std::atomic<uint8_t>[]> counters;
+    std::atomic<size_t> items{0};
+    std::atomic<bool> ready{false};
+};
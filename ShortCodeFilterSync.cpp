@@ -0,0 +1,136 @@
+#include "ShortCodeFilterSync.h"
+#include "ShortCodeFilter.h"
+#include "URLShortnerDB.h"
+
+#include <iostream>
+#include <utility>
+#include <vector>
+
+using std::cerr;
+using std::endl;
+using std::lock_guard;
+using std::mutex;
+using std::string;
+using std::unique_lock;
+
+ShortCodeFilterSync::ShortCodeFilterSync(UrlShortenerDB& db_instance, ShortCodeFilter& codeFilter,
+                                         std::chrono::seconds interval)
+    : db(db_instance), filter(codeFilter), syncInterval(interval) {
+    if (syncInterval.count() > 0) {
+        syncer = std::thread(&ShortCodeFilterSync::run, this);
+    }
+}
+
+ShortCodeFilterSync::~ShortCodeFilterSync() {
+    stop();
+}
+
+bool ShortCodeFilterSync::addOnce(unsigned int id, const string& code) {
+    // Ids at or below the floor are no longer tracked; adding one twice only
+    // costs a false positive, while skipping a late commit would hide a link
+    if (id > floorId() && !recentIds.insert(id).second) return false;
+
+    filter.add(code);
+    if (id > highest) {
+        highest = id;
+        recentIds.erase(recentIds.begin(), recentIds.upper_bound(floorId()));
+    }
+    return true;
+}
+
+bool ShortCodeFilterSync::load() {
+    lock_guard<mutex> syncLock(syncMutex);
+    if (filter.isReady()) return true; // Already loaded by the other caller
+
+    size_t loaded = 0;
+    bool ok = db.forEachShortCodeAfter(0, [this, &loaded](unsigned int id, const string& code) {
+        lock_guard<mutex> lock(seenMutex);
+        if (addOnce(id, code)) ++loaded;
+    });
+    if (!ok) {
+        // Leave the filter disabled: every lookup falls through to the DB
+        failureCount.fetch_add(1, std::memory_order_relaxed);
+        cerr << "DB_ERROR: Failed to load short code filter, retrying in the background." << endl;
+        return false;
+    }
+    filter.markReady();
+
+    cerr << "DB_INFO: Short code filter loaded with " << loaded << " codes ("
+         << filter.memoryBytes() / 1024 << " KiB, estimated false-positive rate "
+         << filter.falsePositiveRate() << ")" << endl;
+    return true;
+}
+
+bool ShortCodeFilterSync::sync() {
+    lock_guard<mutex> syncLock(syncMutex);
+
+    unsigned int after;
+    {
+        lock_guard<mutex> lock(seenMutex);
+        after = floorId();
+    }
+
+    std::vector<std::pair<unsigned int, string>> rows;
+    bool ok = db.forEachShortCodeAfter(after, [&rows](unsigned int id, const string& code) {
+        rows.emplace_back(id, code);
+    });
+    if (!ok) {
+        failureCount.fetch_add(1, std::memory_order_relaxed);
+        cerr << "DB_WARN: Could not sync the short code filter, retrying in " << syncInterval.count() << "s." << endl;
+        return false;
+    }
+
+    unsigned long long fresh = 0;
+    {
+        lock_guard<mutex> lock(seenMutex);
+        for (const auto& row : rows) {
+            if (addOnce(row.first, row.second)) ++fresh;
+        }
+    }
+    syncedCount.fetch_add(fresh, std::memory_order_relaxed);
+    return true;
+}
+
+void ShortCodeFilterSync::added(unsigned int id, const string& code) {
+    lock_guard<mutex> lock(seenMutex);
+    addOnce(id, code);
+}
+
+bool ShortCodeFilterSync::removed(unsigned int id, const string& code) {
+    lock_guard<mutex> lock(seenMutex);
+    // Ids at or below the floor were all added by load() or a sync pass; above it only the tracked ones
+    if (!filter.isReady() || id == 0 || (id > floorId() && recentIds.count(id) == 0)) return false;
+    filter.remove(code);
+    return true;
+}
+
+unsigned int ShortCodeFilterSync::highestId() const {
+    lock_guard<mutex> lock(seenMutex);
+    return highest;
+}
+
+void ShortCodeFilterSync::run() {
+    unique_lock<mutex> lock(wakeMutex);
+    while (!stopping) {
+        wakeCv.wait_for(lock, syncInterval, [this] { return stopping; });
+        if (stopping) break;
+
+        lock.unlock();
+        if (filter.isReady()) {
+            sync();
+        } else {
+            load();
+        }
+        lock.lock();
+    }
+}
+
+void ShortCodeFilterSync::stop() {
+    {
+        lock_guard<mutex> lock(wakeMutex);
+        if (stopping) return;
+        stopping = true;
+    }
+    wakeCv.notify_one();
+    if (syncer.joinable()) syncer.join();
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+
+class UrlShortenerDB;
+class ShortCodeFilter;
+
+// Keeps a ShortCodeFilter in step with shortened_links across instances.
+//
+// load() streams every code into the filter and enables it. The background
+// thread then adds every row with an id above the highest one seen, so a
+// link created by another process stops answering "definitely absent"
+// within one syncInterval. Ids are assigned at insert but become visible at
+// commit, not always in order, so each pass re-reads the last ID_OVERLAP
+// ids. Ids already added are remembered and skipped, which keeps the
+// counters exact for links created here too.
+//
+// Deletions made elsewhere are not seen, nor are deletions here of rows not
+// yet synced. Their codes stay positive and fall through to the DB, which is
+// always safe. If the initial load failed, the thread retries it.
+class ShortCodeFilterSync {
+public:
+    ShortCodeFilterSync(UrlShortenerDB& db, ShortCodeFilter& filter, std::chrono::seconds syncInterval);
+    ~ShortCodeFilterSync();
+
+    ShortCodeFilterSync(const ShortCodeFilterSync&) = delete;
+    ShortCodeFilterSync& operator=(const ShortCodeFilterSync&) = delete;
+
+    // Full load of shortened_links, then marks the filter ready
+    bool load();
+    // Adds rows committed since the last pass (also called by the background thread)
+    bool sync();
+    // A link created by this process, visible in the filter right away
+    void added(unsigned int id, const std::string& code);
+    // A link deleted by this process. The code is removed only if its id was added here:
+    // decrementing counters the code never set would hide other codes. Returns whether it was
+    bool removed(unsigned int id, const std::string& code);
+    void stop();
+
+    unsigned int highestId() const;
+    unsigned long long synced() const { return syncedCount.load(std::memory_order_relaxed); }
+    unsigned long long failures() const { return failureCount.load(std::memory_order_relaxed); }
+
+private:
+    static constexpr unsigned int ID_OVERLAP = 1024;
+
+    // Caller holds seenMutex; returns true if the code was new to the filter
+    bool addOnce(unsigned int id, const std::string& code);
+    unsigned int floorId() const { return highest > ID_OVERLAP ? highest - ID_OVERLAP : 0; }
+    void run();
+
+    UrlShortenerDB& db;
+    ShortCodeFilter& filter;
+    std::chrono::seconds syncInterval;
+
+    mutable std::mutex seenMutex;
+    std::set<unsigned int> recentIds; // Added ids above floorId()
+    unsigned int highest = 0;
+
+    std::atomic<unsigned long long> syncedCount{0};
+    std::atomic<unsigned long long> failureCount{0};
+
+    std::mutex syncMutex; // One load/sync pass at a time
+    std::mutex wakeMutex;
+    std::condition_variable wakeCv;
+    bool stopping = false;
+    std::thread syncer;
+};
@@ -0,0 +1,43 @@
+#include "StatementCache.h"
+
+using mysqlx::RowResult;
+using mysqlx::TableSelect;
+using mysqlx::Value;
+using std::string;
+
+StatementCache::StatementCache(mysqlx::Session& s, const string& schema, StatementCacheStats& counters)
+    : session(s), schemaName(schema), stats(counters) {}
+
+TableSelect& StatementCache::statementFor(Query query) {
+    auto& slot = statements[static_cast<size_t>(query)];
+    if (slot) {
+        stats.hits.fetch_add(1, std::memory_order_relaxed);
+        return *slot;
+    }
+
+    mysqlx::Schema schema = session.getSchema(schemaName);
+    switch (query) {
+        case Query::LinkByCode:
+            // Check for the code AND ensure it hasn't expired (Link Expiration)
+            slot = std::make_unique<TableSelect>(schema.getTable("shortened_links")
+                .select("id", "original_url", "short_code", "user_id", "expires_at", "clicks"));
+            slot->where("short_code = :key AND (expires_at IS NULL OR expires_at > NOW())");
+            break;
+        case Query::SessionByToken:
+            slot = std::make_unique<TableSelect>(schema.getTable("sessions")
+                .select("id", "user_id", "session_token", "expires_at",
+                        "expires_at > NOW() AS live", "revoked_at IS NOT NULL AS revoked"));
+            slot->where("session_token = :key");
+            break;
+        case Query::Count:
+            break;
+    }
+    stats.prepares.fetch_add(1, std::memory_order_relaxed);
+    return *slot;
+}
+
+RowResult StatementCache::execute(Query query, const Value& key) {
+    TableSelect& statement = statementFor(query);
+    statement.bind("key", key);
+    return statement.execute();
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <memory>
+#include <string>
+
+#include <mysqlx/xdevapi.h>
+
+// Hit/prepare counters shared by all sessions' caches
+struct StatementCacheStats {
+    std::atomic<unsigned long long> hits{0};     // Executions that reused a statement object
+    std::atomic<unsigned long long> prepares{0}; // Statement objects built (once per session and query)
+};
+
+// Reusable statements for the hot single-key lookups of one pooled session.
+//
+// Each query is built once per session as a CRUD statement with a named
+// placeholder and then only re-bound and executed. X DevAPI prepares a
+// statement on the server when the same statement object is executed again
+// with new bind values, so from the second call on the server no longer
+// parses the query. Named binds replace the previous value, which plain
+// sql() statements (positional, append-only binds) do not allow.
+//
+// Not thread-safe: it belongs to one session, and a session is only used by
+// the thread that checked it out of the pool.
+class StatementCache {
+public:
+    enum class Query {
+        LinkByCode,      // Live link by short_code
+        SessionByToken,  // Session row by session_token, with live/revoked flags
+        Count
+    };
+
+    StatementCache(mysqlx::Session& session, const std::string& schema, StatementCacheStats& stats);
+
+    // Binds `key` to the query's :key placeholder and executes it
+    mysqlx::RowResult execute(Query query, const mysqlx::Value& key);
+
+private:
+    mysqlx::TableSelect& statementFor(Query query);
+
+    mysqlx::Session& session;
+    std::string schemaName;
+    StatementCacheStats& stats;
+    std::array<std::unique_ptr<mysqlx::TableSelect>, static_cast<size_t>(Query::Count)> statements;
+};
@@ -6,12 +6,16 @@
 #include "Modals/ShortenedLink.h"
 #include "Modals/QuotaDTO.h"
 
+#include <algorithm>
 #include <iostream>
 #include <sstream>
 #include <stdexcept>
 #include <fstream>
 #include <iomanip>
 #include <chrono>
+#include <cstdio>
+#include <ctime>
+#include <functional>
 
 using std::cerr;
 using std::cout;
@@ -27,52 +31,76 @@ using mysqlx::abi2::RowResult;
 
 // --- CONNECTION POOL HELPERS ---
 
+// Undoes an open transaction after a failed statement; a broken session has nothing left to undo
+static void rollbackQuietly(mysqlx::Session* session) {
+    if (!session) return;
+    try {
+        session->rollback();
+    } catch (const std::exception&) {
+    }
+}
+
+// Errors that leave the session itself unusable, as opposed to a statement the server rejected
+static bool isConnectionError(const std::exception& e) {
+    static const char* const markers[] = {"CDK Error", "Lost connection", "Connection reset", "Connection refused",
+                                          "Connection closed", "gone away"};
+    const string message = e.what();
+    for (const char* marker : markers) {
+        if (message.find(marker) != string::npos) return true;
+    }
+    return false;
+}
+
 std::unique_ptr<mysqlx::Session> UrlShortenerDB::getConnection() {
-    unique_lock<std::mutex> lock(poolMutex);
-    
-    // Wait until the pool has a connection available (with a timeout)
-    if (connectionPool.empty()) {
-        if (poolCv.wait_for(lock, std::chrono::seconds(5)) == std::cv_status::timeout) {
-            throw std::runtime_error("Database pool timeout: No connections available.");
-        }
+    if (!pool) {
+        throw std::runtime_error("Database pool is not initialized.");
     }
-    
-    if (connectionPool.empty()) {
-        throw std::runtime_error("Database pool is empty after waiting.");
+    // Waits up to DB_POOL_ACQUIRE_TIMEOUT_MS, growing the pool if it has room
+    return pool->acquire();
+}
+
+void UrlShortenerDB::returnConnection(std::unique_ptr<mysqlx::Session> session) {
+    if (session && pool) {
+        pool->release(std::move(session));
     }
+}
 
-    // De-queue the connection and return it
-    std::unique_ptr<mysqlx::Session> session = std::move(connectionPool.front());
-    connectionPool.pop();
-    
-    return session;
+void UrlShortenerDB::discardIfBroken(std::unique_ptr<mysqlx::Session>& session, const std::exception& e,
+                                     ReplicaRouter::Replica* replica) {
+    if (session && isConnectionError(e)) {
+        poolOf(replica).release(std::move(session), true);
+    }
 }
 
-std::string UrlShortenerDB::getConfig(mysqlx::Session& currentSession, std::string key){
-    std::string value = "";
-    try
-    {
-        string sql = "SELECT setting_value FROM global_settings WHERE setting_key = ?";
-        // Use the passed-in currentSession
-        auto result = executeStatement(currentSession, sql, {Value(key)}); 
-        
-        if (auto row = result->fetchOne()) {
-            value = row[0].get<string>();
+std::unique_ptr<mysqlx::Session> UrlShortenerDB::getReadConnection(ReplicaRouter::Replica*& replica,
+                                                                   ReplicaRouter::Key kind, const std::string& id) {
+    replica = nullptr;
+    if (replicaRouter) {
+        if (replicaRouter->isSticky(kind, id)) {
+            // Read-your-writes: the replica may not have this row yet
+            replicaRouter->countSticky();
+        } else if ((replica = replicaRouter->pick())) {
+            try {
+                return replica->pool->acquire();
+            } catch (const std::exception& e) {
+                cerr << "DB_WARN: Replica " << replica->name << " unavailable, reading from the primary: " << e.what() << endl;
+                replicaRouter->markDown(replica);
+                replicaRouter->finished(replica);
+                replica = nullptr;
+                replicaRouter->countFallback();
+            }
+        } else {
+            replicaRouter->countFallback();
         }
     }
-    catch(const std::exception& e)
-    {
-        value = "invalid request"; 
-    }
-    // Removed returnConnection(std::move(currentSession));
-    return value;
+    return getConnection();
 }
-void UrlShortenerDB::returnConnection(std::unique_ptr<mysqlx::Session> session) {
+
+void UrlShortenerDB::returnReadConnection(std::unique_ptr<mysqlx::Session> session, ReplicaRouter::Replica* replica) {
     if (session) {
-        lock_guard<std::mutex> lock(poolMutex);
-        connectionPool.push(std::move(session));
-        poolCv.notify_one(); // Notify one waiting thread that a connection is free
+        poolOf(replica).release(std::move(session));
     }
+    if (replica) replicaRouter->finished(replica);
 }
 
 
@@ -80,33 +108,62 @@ void UrlShortenerDB::returnConnection(std::unique_ptr<mysqlx::Session> session)
 
 string UrlShortenerDB::getTodayDate() {
     time_t now = time(nullptr);
-    struct tm *ltm = localtime(&now); 
+    struct tm ltm; // localtime() shares one static buffer across threads
+    localtime_r(&now, &ltm);
     char buffer[11]; // YYYY-MM-DD\0
-    strftime(buffer, sizeof(buffer), "%Y-%m-%d", ltm);
+    strftime(buffer, sizeof(buffer), "%Y-%m-%d", &ltm);
     return buffer;
 }
 
 // Generates a future timestamp for session/link expiration
 string UrlShortenerDB::getFutureTimestamp(int days) {
     auto now = std::chrono::system_clock::now();
-    auto future = now + std::chrono::minutes(24 * days);
+    auto future = now + std::chrono::hours(24 * days);
     time_t future_time = std::chrono::system_clock::to_time_t(future);
     
-    struct tm *ltm = localtime(&future_time); 
+    struct tm ltm;
+    localtime_r(&future_time, &ltm);
     char buffer[20];
-    strftime(buffer, sizeof(buffer), "%Y-%m-%d %H:%M:%S", ltm);
+    strftime(buffer, sizeof(buffer), "%Y-%m-%d %H:%M:%S", &ltm);
     return buffer;
 }
 
 // Helper function to get the current time (YYYY-MM-DD HH:MM:SS)
 string UrlShortenerDB::getCurrentTimestamp() {
     time_t now = time(nullptr);
-    struct tm *ltm = localtime(&now); 
+    struct tm ltm;
+    localtime_r(&now, &ltm);
     char buffer[20];
-    strftime(buffer, sizeof(buffer), "%Y-%m-%d %H:%M:%S", ltm);
+    strftime(buffer, sizeof(buffer), "%Y-%m-%d %H:%M:%S", &ltm);
     return buffer;
 }
 
+// Formats epoch seconds as a DB timestamp (local time); "" for 0
+string UrlShortenerDB::formatTimestamp(std::time_t epoch) {
+    if (epoch == 0) return "";
+    struct tm ltm; // Called concurrently from the snapshot redirect path
+    localtime_r(&epoch, &ltm);
+    char buffer[20];
+    strftime(buffer, sizeof(buffer), "%Y-%m-%d %H:%M:%S", &ltm);
+    return buffer;
+}
+
+// Parses a DB timestamp (YYYY-MM-DD HH:MM:SS, local time) into epoch seconds
+std::time_t UrlShortenerDB::parseTimestamp(const string& timestamp) {
+    if (timestamp.empty()) return 0;
+    struct tm tm_value = {};
+    if (sscanf(timestamp.c_str(), "%d-%d-%d %d:%d:%d",
+               &tm_value.tm_year, &tm_value.tm_mon, &tm_value.tm_mday,
+               &tm_value.tm_hour, &tm_value.tm_min, &tm_value.tm_sec) < 3) {
+        return 0;
+    }
+    tm_value.tm_year -= 1900;
+    tm_value.tm_mon -= 1;
+    tm_value.tm_isdst = -1;
+    std::time_t result = mktime(&tm_value);
+    return result == -1 ? 0 : result;
+}
+
 // Helper method implementation (DECOUPLED FROM SHARED MEMBER)
 unique_ptr<RowResult> UrlShortenerDB::executeStatement(
     mysqlx::Session& currentSession, // Session parameter
@@ -125,6 +182,17 @@ unique_ptr<RowResult> UrlShortenerDB::executeStatement(
     return unique_ptr<RowResult>(new RowResult(stmt.execute()));
 }
 
+// Fixed hot-path lookups: re-bind and execute this session's reusable statement
+unique_ptr<RowResult> UrlShortenerDB::executeCached(mysqlx::Session& currentSession,
+                                                    StatementCache::Query query, const Value& key) {
+    return executeCached(*pool, currentSession, query, key);
+}
+
+unique_ptr<RowResult> UrlShortenerDB::executeCached(ConnectionPool& owner, mysqlx::Session& currentSession,
+                                                    StatementCache::Query query, const Value& key) {
+    return unique_ptr<RowResult>(new RowResult(owner.statementsFor(currentSession).execute(query, key)));
+}
+
 
 // --- UrlShortenerDB Implementation ---
 
@@ -133,36 +201,105 @@ UrlShortenerDB::UrlShortenerDB() {
 }
 
 UrlShortenerDB::~UrlShortenerDB() {
-    // All sessions in the pool are closed automatically when unique_ptr is destroyed
+    if (guestQuota) guestQuota->stop(); // Writes the last quota deltas while the pool is still up
+    if (codeFilterSync) codeFilterSync->stop();
+    if (snapshotTombstones) snapshotTombstones->stop();
+    if (settings) settings->stop();
+    // Stop maintenance first; idle sessions are closed when the pools are destroyed
+    if (replicaRouter) replicaRouter->stop();
+    if (pool) pool->stop();
 }
 
 bool UrlShortenerDB::connect() {
     // Use a temporary session object to establish connections for the pool
     std::unique_ptr<mysqlx::Session> tempSession; 
+    linkCache = std::make_unique<LinkCache>(Config::LINK_CACHE_CAPACITY, Config::LINK_CACHE_MAX_AGE_SECONDS);
+    if (Config::DEDUPE_LINKS) {
+        linkDedupe = std::make_unique<LinkDedupeIndex>(Config::DEDUPE_INDEX_CAPACITY);
+    }
+    sessionCache = std::make_unique<SessionCache>(Config::SESSION_CACHE_CAPACITY, Config::SESSION_CACHE_MAX_AGE_SECONDS,
+                                                  Config::SESSION_CACHE_NEGATIVE_TTL_SECONDS);
+    if (Config::SHORT_CODE_FILTER_CAPACITY > 0) {
+        codeFilter = std::make_unique<ShortCodeFilter>(Config::SHORT_CODE_FILTER_CAPACITY, Config::SHORT_CODE_FILTER_FPR);
+        codeFilterSync = std::make_unique<ShortCodeFilterSync>(*this, *codeFilter,
+                                                               std::chrono::seconds(Config::SHORT_CODE_FILTER_SYNC_SECONDS));
+    }
     try {
+        // --- CREATE DATABASE (Use the first session for DDL) ---
+        tempSession = std::make_unique<mysqlx::Session>(
+            Config::DB_HOST, 
+            Config::DB_PORT, 
+            Config::DB_USER, 
+            Config::DB_PASS
+        );
+        tempSession->sql("CREATE DATABASE IF NOT EXISTS " + Config::DB_NAME).execute();
+
+        tempSession.reset();
+
         // --- INITIALIZE POOL ---
-        for (int i = 0; i < poolSize; ++i) {
-            tempSession = std::make_unique<mysqlx::Session>(
-                Config::DB_HOST, 
-                Config::DB_PORT, 
-                Config::DB_USER, 
+        // Every pooled session must have the schema selected: calls can run on
+        // any session concurrently, not just the one that ran the DDL.
+        ConnectionPool::Options options;
+        options.minSize = static_cast<size_t>(std::max(1, Config::DB_POOL_MIN));
+        options.maxSize = static_cast<size_t>(std::max(Config::DB_POOL_MIN, Config::DB_POOL_MAX));
+        options.acquireTimeout = std::chrono::milliseconds(Config::DB_POOL_ACQUIRE_TIMEOUT_MS);
+        options.idleTimeout = std::chrono::seconds(Config::DB_POOL_IDLE_TIMEOUT_SECONDS);
+        options.validationInterval = std::chrono::seconds(Config::DB_POOL_VALIDATION_INTERVAL_SECONDS);
+
+        pool = std::make_unique<ConnectionPool>([] {
+            auto session = std::make_unique<mysqlx::Session>(
+                Config::DB_HOST,
+                Config::DB_PORT,
+                Config::DB_USER,
                 Config::DB_PASS
             );
-            
-            // Add the new, fully connected session to the pool
-            connectionPool.push(std::move(tempSession));
+            session->sql("USE " + Config::DB_NAME).execute();
+            return session;
+        }, options, Config::DB_NAME, statementStats);
+
+        if (!pool->start()) {
+            cerr << "DB_ERROR: Could not open any pooled session to " << Config::DB_NAME << endl;
+            pool.reset();
+            isConnected = false;
+            return false;
         }
 
-        // --- CREATE DATABASE (Use a single pool session for DDL) ---
-        // We use one connection from the pool for initial DDL (Data Definition Language)
-        tempSession = getConnection(); 
-        tempSession->sql("CREATE DATABASE IF NOT EXISTS " + Config::DB_NAME).execute();
-        tempSession->sql("USE " + Config::DB_NAME).execute();
-        
-        // Return the session to the pool
-        returnConnection(std::move(tempSession));
+        ConnectionPool::Stats poolStats = pool->stats();
+        cerr << "DB_INFO: Database connection pool established with " << poolStats.total << " sessions (max "
+             << options.maxSize << ") to " << Config::DB_NAME << endl;
+
+        // --- READ REPLICAS ---
+        // An unreachable replica is skipped, reads then stay on the primary
+        if (!Config::DB_REPLICAS.empty()) {
+            replicaRouter = std::make_unique<ReplicaRouter>(std::chrono::milliseconds(Config::READ_YOUR_WRITES_WINDOW_MS));
+            std::stringstream list(Config::DB_REPLICAS);
+            string entry;
+            while (std::getline(list, entry, ',')) {
+                if (entry.empty()) continue;
+                size_t colon = entry.rfind(':');
+                string host = entry.substr(0, colon);
+                int port = colon == string::npos ? Config::DB_PORT : std::stoi(entry.substr(colon + 1));
+
+                auto replicaPool = std::make_unique<ConnectionPool>([host, port] {
+                    auto session = std::make_unique<mysqlx::Session>(host, port, Config::DB_USER, Config::DB_PASS);
+                    session->sql("USE " + Config::DB_NAME).execute();
+                    return session;
+                }, options, Config::DB_NAME, statementStats);
+
+                if (!replicaPool->start()) {
+                    cerr << "DB_WARN: Read replica " << entry << " is unreachable, skipping it." << endl;
+                    continue;
+                }
+                cerr << "DB_INFO: Read replica " << entry << " added." << endl;
+                replicaRouter->addReplica(entry, std::move(replicaPool));
+            }
+            if (replicaRouter->size() == 0) replicaRouter.reset();
+        }
 
-        cerr << "DB_INFO: Database connection pool established with " << poolSize << " sessions to " << Config::DB_NAME << endl;
+        // Loaded by setupDatabase() once the table exists, then refreshed in the background
+        settings = std::make_unique<GlobalSettingsCache>(*this, std::chrono::seconds(Config::SETTINGS_REFRESH_SECONDS));
+        // Today's usage is loaded by setupDatabase()
+        guestQuota = std::make_unique<GuestQuotaCounter>(*this, std::chrono::milliseconds(Config::GUEST_QUOTA_FLUSH_INTERVAL_MS));
 
         isConnected = true;
         return true;
@@ -178,6 +315,117 @@ bool UrlShortenerDB::connect() {
     }
 }
 
+// Streams every short code into the existence filter, then enables it
+bool UrlShortenerDB::loadShortCodeFilter() {
+    if (!codeFilterSync) return true;
+    if (!isConnected) return false;
+    return codeFilterSync->load();
+}
+
+bool UrlShortenerDB::forEachShortCodeAfter(unsigned int after_id,
+                                           const std::function<void(unsigned int, const string&)>& callback) {
+    if (!isConnected) return false;
+    std::unique_ptr<mysqlx::Session> currentSession;
+    try {
+        // Primary only: a lagging replica would hide fresh codes for longer
+        currentSession = getConnection();
+        auto result = executeStatement(*currentSession,
+                                       "SELECT id, short_code FROM shortened_links WHERE id > ? ORDER BY id",
+                                       {Value(after_id)});
+        for (auto row : *result) {
+            callback(row[0].get<unsigned int>(), row[1].get<string>());
+        }
+        returnConnection(std::move(currentSession));
+        return true;
+    } catch (const std::exception& e) {
+        cerr << "DB_ERROR: Failed to stream short codes: " << e.what() << endl;
+        discardIfBroken(currentSession, e);
+        returnConnection(std::move(currentSession));
+        return false;
+    }
+}
+
+bool UrlShortenerDB::openLinkSnapshot(const string& path) {
+    if (!isConnected) return false;
+    auto snapshot = std::make_unique<LinkSnapshot>();
+    if (!snapshot->open(path)) return false;
+
+    // Older tombstones are purged, so deletions made before then would be served again
+    const std::time_t oldest = std::time(nullptr) - std::time_t(Config::LINK_TOMBSTONE_RETENTION_DAYS) * 24 * 3600;
+    if (snapshot->createdAt() < oldest) {
+        cerr << "DB_ERROR: Link snapshot " << path << " is older than LINK_TOMBSTONE_RETENTION_DAYS ("
+             << Config::LINK_TOMBSTONE_RETENTION_DAYS << "), regenerate it." << endl;
+        return false;
+    }
+
+    // Deletions recorded since the snapshot was built, with a margin for clock skew
+    auto tombstones = std::make_unique<LinkTombstones>(*this, std::chrono::seconds(Config::LINK_SNAPSHOT_SYNC_SECONDS));
+    if (!tombstones->start(snapshot->createdAt() - SNAPSHOT_CLOCK_SKEW_SECONDS)) {
+        cerr << "DB_ERROR: Could not load deletions since the link snapshot was built." << endl;
+        return false;
+    }
+
+    cerr << "DB_INFO: Link snapshot " << path << " mapped with " << snapshot->size() << " links, "
+         << tombstones->size() << " deleted since." << endl;
+    snapshotTombstones = std::move(tombstones);
+    linkSnapshot = std::move(snapshot);
+    return true;
+}
+
+bool UrlShortenerDB::forEachDeletedCode(uint64_t after_id, std::time_t since,
+                                        const std::function<void(uint64_t, const string&)>& callback) {
+    if (!isConnected) return false;
+    std::unique_ptr<mysqlx::Session> currentSession;
+    try {
+        // Primary only: a deletion must not hide behind replication lag
+        currentSession = getConnection();
+        auto result = executeStatement(*currentSession,
+                                       "SELECT id, short_code FROM deleted_codes"
+                                       " WHERE id > ? AND deleted_at >= FROM_UNIXTIME(?) ORDER BY id",
+                                       {Value(after_id), Value(static_cast<int64_t>(since))});
+        for (auto row : *result) {
+            callback(row[0].get<uint64_t>(), row[1].get<string>());
+        }
+        returnConnection(std::move(currentSession));
+        return true;
+    } catch (const std::exception& e) {
+        cerr << "DB_ERROR: Failed to read deleted codes: " << e.what() << endl;
+        discardIfBroken(currentSession, e);
+        returnConnection(std::move(currentSession));
+        return false;
+    }
+}
+
+bool UrlShortenerDB::forEachLiveLink(const std::function<void(const ShortenedLink&)>& callback) {
+    if (!isConnected) return false;
+    std::unique_ptr<mysqlx::Session> currentSession;
+    try {
+        currentSession = getConnection();
+        string sql = "SELECT id, original_url, short_code, user_id, expires_at FROM shortened_links "
+                     "WHERE expires_at IS NULL OR expires_at > NOW()";
+        auto result = executeStatement(*currentSession, sql, {});
+
+        for (auto row : *result) {
+            ShortenedLink link;
+            link.id = row[0].get<unsigned int>();
+            link.original_url = row[1].get<string>();
+            link.short_code = row[2].get<string>();
+            if (!row[3].isNull()) {
+                link.user_id = std::make_unique<unsigned int>(row[3].get<unsigned int>());
+            }
+            link.expires_at = row[4].isNull() ? "" : row[4].get<string>();
+            callback(link);
+        }
+        returnConnection(std::move(currentSession));
+        return true;
+    } catch (const std::exception& e) {
+        cerr << "DB_ERROR: Failed to stream links: " << e.what() << endl;
+        discardIfBroken(currentSession, e);
+        returnConnection(std::move(currentSession));
+        return false;
+    }
+}
+
 // Uses pool session and correct EXECUTE HELPER
 bool UrlShortenerDB::incrementEndpointStat(const std::string& endpoint,
                                            const std::string& method,
@@ -204,11 +452,73 @@ bool UrlShortenerDB::incrementEndpointStat(const std::string& endpoint,
         return true;
     } catch (const std::exception& e) {
         std::cerr << "DB_ERROR: Failed to update endpoint stats: " << e.what() << std::endl;
+        discardIfBroken(currentSession, e);
         returnConnection(std::move(currentSession));
         return false;
     }
 }
 
+// Applies coalesced endpoint stat deltas with one multi-row upsert per chunk
+bool UrlShortenerDB::addEndpointStats(const std::vector<EndpointStat>& stats) {
+    if (!isConnected) return false;
+    if (stats.empty()) return true;
+    const size_t CHUNK_SIZE = 500;
+    std::unique_ptr<mysqlx::Session> currentSession;
+    try {
+        currentSession = getConnection();
+        // All chunks or none: the caller re-queues every stat on failure
+        currentSession->startTransaction();
+
+        for (size_t start = 0; start < stats.size(); start += CHUNK_SIZE) {
+            size_t end = std::min(stats.size(), start + CHUNK_SIZE);
+
+            string sql = "INSERT INTO endpoint_stats (endpoint, endpoint_type, count, created_by, type) VALUES ";
+            std::vector<Value> params;
+            params.reserve((end - start) * 4);
+            for (size_t i = start; i < end; ++i) {
+                sql += (i == start) ? "(?, ?, ?, ?, 'USER')" : ", (?, ?, ?, ?, 'USER')";
+                params.emplace_back(stats[i].endpoint);
+                params.emplace_back(stats[i].endpoint_type);
+                params.emplace_back(stats[i].count);
+                params.emplace_back(stats[i].created_by);
+            }
+            sql += " ON DUPLICATE KEY UPDATE "
+                   "count = count + VALUES(count), "
+                   "created_by = VALUES(created_by), "
+                   "updated_at = CURRENT_TIMESTAMP";
+
+            executeStatement(*currentSession, sql, params);
+        }
+        currentSession->commit();
+        returnConnection(std::move(currentSession));
+        return true;
+    } catch (const std::exception& e) {
+        cerr << "DB_ERROR: Failed to flush endpoint stats: " << e.what() << endl;
+        discardIfBroken(currentSession, e);
+        rollbackQuietly(currentSession.get());
+        returnConnection(std::move(currentSession));
+        return false;
+    }
+}
+
+long long UrlShortenerDB::getServerPrepareCount() {
+    if (!isConnected) return -1;
+    std::unique_ptr<mysqlx::Session> currentSession;
+    long long count = -1;
+    try {
+        currentSession = getConnection();
+        auto result = executeStatement(*currentSession, "SHOW GLOBAL STATUS LIKE 'Mysqlx_prep_prepare'", {});
+        if (auto row = result->fetchOne()) {
+            count = std::stoll(row[1].get<string>());
+        }
+    } catch (const std::exception& e) {
+        cerr << "DB_ERROR: Failed to read prepared statement status: " << e.what() << endl;
+        discardIfBroken(currentSession, e);
+    }
+    returnConnection(std::move(currentSession));
+    return count;
+}
+
 // Uses pool session for DDL execution
 bool UrlShortenerDB::setupDatabase() {
     if (!isConnected) {
@@ -273,6 +583,7 @@ bool UrlShortenerDB::setupDatabase() {
                 currentSession->sql(trimmed).execute(); 
 
             } catch (const mysqlx::Error &e) {
+                if (isConnectionError(e)) throw; // No point running the rest on a dead session
                 cerr << "DB_WARN: Failed to execute SQL statement: " << e.what() << endl;
                 cerr << "Statement: " << stmt << endl;
             }
@@ -280,10 +591,16 @@ bool UrlShortenerDB::setupDatabase() {
 
         returnConnection(std::move(currentSession));
         cerr << "DB_INFO: Schema setup completed successfully." << endl;
+
+        if (reloadGlobalSettings()) {
+            cerr << "DB_INFO: Global settings loaded." << endl;
+        }
+        guestQuota->load(getTodayDate());
         return true;
 
     } catch (const std::exception &e) {
         cerr << "DB_ERROR: Exception while setting up DB: " << e.what() << endl;
+        discardIfBroken(currentSession, e);
         returnConnection(std::move(currentSession));
         return false;
     }
@@ -308,8 +625,9 @@ bool UrlShortenerDB::createUser(const User& user) {
         currentSession->sql(sql).bind(params).execute();
         returnConnection(std::move(currentSession));
         return true;
-    } catch (const mysqlx::Error& e) {
+    } catch (const std::exception& e) {
         cerr << "DB_ERROR: Failed to create user: " << e.what() << endl;
+        discardIfBroken(currentSession, e);
         returnConnection(std::move(currentSession));
         return false;
     }
@@ -337,6 +655,7 @@ unique_ptr<User> UrlShortenerDB::findUserByGoogleId(const string& google_id) {
 
     } catch (const std::exception& e) {
         cerr << "DB_ERROR: Failed to find user by Google ID: " << e.what() << endl;
+        discardIfBroken(currentSession, e);
     }
     returnConnection(std::move(currentSession));
     return user;
@@ -365,6 +684,7 @@ unique_ptr<User> UrlShortenerDB::findUserByEmail(const string& email) {
 
     } catch (const std::exception& e) {
         cerr << "DB_ERROR: Failed to find user by Email: " << e.what() << endl;
+        discardIfBroken(currentSession, e);
     }
     returnConnection(std::move(currentSession));
     return user;
@@ -386,10 +706,14 @@ bool UrlShortenerDB::createSession(const ::Session& sessionObj) {
         };
 
         currentSession->sql(sql).bind(params).execute();
+        // Forget a negative entry in case this token was probed before
+        sessionCache->invalidate(sessionObj.session_token);
+        noteWrite(ReplicaRouter::Key::Token, sessionObj.session_token);
         returnConnection(std::move(currentSession));
         return true;
-    } catch (const mysqlx::Error& e) {
+    } catch (const std::exception& e) {
         cerr << "DB_ERROR: Failed to create session: " << e.what() << endl;
+        discardIfBroken(currentSession, e);
         returnConnection(std::move(currentSession));
         return false;
     }
@@ -401,39 +725,164 @@ bool UrlShortenerDB::deleteSession(const string& token) {
         currentSession = getConnection();
         string sql = "DELETE FROM sessions WHERE session_token = ?";
         currentSession->sql(sql).bind(Value(token)).execute();
+        sessionCache->putInvalid(token);
+        noteWrite(ReplicaRouter::Key::Token, token);
         cerr << "DB_INFO: Session deleted successfully." << endl;
         returnConnection(std::move(currentSession));
         return true;
-    } catch (const mysqlx::Error& e) {
+    } catch (const std::exception& e) {
         cerr << "DB_ERROR: Failed to delete session: " << e.what() << endl;
+        discardIfBroken(currentSession, e);
         returnConnection(std::move(currentSession));
         return false;
     }
 }
 
+bool UrlShortenerDB::revokeSession(const string& token, unsigned int user_id, std::time_t token_expires) {
+    if (!isConnected) return false;
+    std::unique_ptr<mysqlx::Session> currentSession;
+    try {
+        currentSession = getConnection();
+        if (token_expires != 0) {
+            // Every instance reads revocations from this row until it expires
+            string sql = "INSERT INTO sessions (user_id, session_token, expires_at, revoked_at, created_at, updated_at) "
+                         "VALUES (?, ?, FROM_UNIXTIME(?), NOW(), NOW(), NOW()) "
+                         "ON DUPLICATE KEY UPDATE revoked_at = COALESCE(revoked_at, NOW()), "
+                         "expires_at = GREATEST(expires_at, VALUES(expires_at))";
+            executeStatement(*currentSession, sql,
+                             {Value(user_id), Value(token), Value(static_cast<int64_t>(token_expires))});
+        } else {
+            string sql = "UPDATE sessions SET revoked_at = NOW() WHERE session_token = ? AND revoked_at IS NULL";
+            currentSession->sql(sql).bind(Value(token)).execute();
+        }
+        sessionCache->putInvalid(token);
+        noteWrite(ReplicaRouter::Key::Token, token);
+        cerr << "DB_INFO: Session revoked successfully." << endl;
+        returnConnection(std::move(currentSession));
+        return true;
+    } catch (const std::exception& e) {
+        cerr << "DB_ERROR: Failed to revoke session: " << e.what() << endl;
+        discardIfBroken(currentSession, e);
+        returnConnection(std::move(currentSession));
+        return false;
+    }
+}
+
+unique_ptr<std::vector<string>> UrlShortenerDB::getRevokedSessionTokens() {
+    if (!isConnected) return nullptr;
+    std::unique_ptr<mysqlx::Session> currentSession;
+    unique_ptr<std::vector<string>> tokens = nullptr;
+
+    try {
+        currentSession = getConnection();
+        string sql = "SELECT session_token FROM sessions WHERE revoked_at IS NOT NULL AND expires_at > NOW() AND session_token LIKE 'v1.%'";
+        auto result = executeStatement(*currentSession, sql, {});
+
+        tokens = std::make_unique<std::vector<string>>();
+        for (auto row : *result) {
+            tokens->push_back(row[0].get<string>());
+        }
+    } catch (const std::exception& e) {
+        cerr << "DB_ERROR: Failed to load revoked sessions: " << e.what() << endl;
+        discardIfBroken(currentSession, e);
+        tokens = nullptr;
+    }
+    returnConnection(std::move(currentSession));
+    return tokens;
+}
+
+long long UrlShortenerDB::purgeExpiredSessions(size_t limit) {
+    if (!isConnected) return -1;
+    std::unique_ptr<mysqlx::Session> currentSession;
+    long long deleted = -1;
+    try {
+        currentSession = getConnection();
+        // Uses ix_expires_at; LIMIT keeps each statement's locks short
+        mysqlx::SqlResult result =
+            currentSession->sql("DELETE FROM sessions WHERE expires_at < NOW() LIMIT " + std::to_string(limit)).execute();
+        deleted = static_cast<long long>(result.getAffectedItemsCount());
+    } catch (const std::exception& e) {
+        cerr << "DB_ERROR: Failed to purge expired sessions: " << e.what() << endl;
+        discardIfBroken(currentSession, e);
+    }
+    returnConnection(std::move(currentSession));
+    return deleted;
+}
+
 unique_ptr<::Session> UrlShortenerDB::findSessionByToken(const string& token) {
     if (!isConnected) return nullptr;
+
+    // Most authenticated requests are answered here without touching MySQL
+    std::shared_ptr<const CachedSession> cached;
+    if (sessionCache->lookup(token, cached)) {
+        if (!cached) return nullptr; // Known-bad token
+        auto sessionObj = std::make_unique<::Session>();
+        sessionObj->id = cached->id;
+        sessionObj->user_id = cached->user_id;
+        sessionObj->session_token = token;
+        sessionObj->expires_at = cached->expires_at;
+        return sessionObj;
+    }
+
     std::unique_ptr<mysqlx::Session> currentSession;
+    ReplicaRouter::Replica* replica = nullptr;
     unique_ptr<::Session> sessionObj = nullptr;
 
     try {
-        currentSession = getConnection();
-        string sql = "SELECT id, user_id, session_token, expires_at FROM sessions WHERE session_token = ? AND expires_at > NOW()";
-        auto result = executeStatement(*currentSession, sql, {Value(token)}); 
-        
-        if (auto row = result->fetchOne()) {
-            sessionObj = std::make_unique<::Session>();
-            
-            sessionObj->id = row[0].get<unsigned int>(); 
-            sessionObj->user_id = row[1].get<unsigned int>(); 
-            sessionObj->session_token = row[2].get<string>();
-            sessionObj->expires_at = row[3].get<string>();
+        currentSession = getReadConnection(replica, ReplicaRouter::Key::Token, token);
+        auto result = executeCached(poolOf(replica), *currentSession, StatementCache::Query::SessionByToken, Value(token));
+        mysqlx::Row row = result->fetchOne();
+
+        if (!row && replica) {
+            // A login on another instance may not have replicated yet (stickiness is per
+            // process): confirm on the primary before caching the token as bad
+            result.reset();
+            returnReadConnection(std::move(currentSession), replica);
+            replica = nullptr;
+            currentSession = getConnection();
+            result = executeCached(*currentSession, StatementCache::Query::SessionByToken, Value(token));
+            row = result->fetchOne();
+        }
+
+        if (row) {
+            bool live = row[4].get<int>() != 0;
+            bool revoked = row[5].get<int>() != 0;
+            if (live && !revoked) {
+                sessionObj = std::make_unique<::Session>();
+
+                sessionObj->id = row[0].get<unsigned int>(); 
+                sessionObj->user_id = row[1].get<unsigned int>(); 
+                sessionObj->session_token = row[2].get<string>();
+                sessionObj->expires_at = row[3].get<string>();
+
+                CachedSession entry;
+                entry.id = sessionObj->id;
+                entry.user_id = sessionObj->user_id;
+                entry.expires_at = sessionObj->expires_at;
+                entry.expires_epoch = parseTimestamp(sessionObj->expires_at);
+                sessionCache->put(token, std::move(entry));
+            } else if (revoked) {
+                // Kept until it expires so every instance's revocation list picks it up
+                sessionCache->putInvalid(token);
+            } else {
+                // Token Expiration Cleanup: only rows that really exist are deleted,
+                // so random bogus tokens never turn into DELETEs. Replicas are
+                // read-only; the row is then removed by a later primary read.
+                if (!replica) {
+                    executeStatement(*currentSession, "DELETE FROM sessions WHERE session_token = ?", {Value(token)});
+                    cerr << "DB_INFO: Expired session deleted." << endl;
+                }
+                sessionCache->putInvalid(token);
+            }
+        } else {
+            sessionCache->putInvalid(token);
         }
 
     } catch (const std::exception& e) {
         cerr << "DB_ERROR: Failed to find session: " << e.what() << endl;
+        discardIfBroken(currentSession, e, replica);
     }
-    returnConnection(std::move(currentSession));
+    returnReadConnection(std::move(currentSession), replica);
     return sessionObj;
 }
 bool UrlShortenerDB::setLinkFavorite(const int&userId, const string&code, const bool&isFav){
@@ -449,10 +898,13 @@ bool UrlShortenerDB::setLinkFavorite(const int&userId, const string&code, const
         };
         UrlShortenerDB::executeStatement(*currentSession, sql, params); 
         returnConnection(std::move(currentSession));
+        noteWrite(ReplicaRouter::Key::User, std::to_string(userId));
+        noteWrite(ReplicaRouter::Key::ShortCode, code);
         return true;
     }
-    catch (const mysqlx::Error &e) {
+    catch (const std::exception& e) {
         cerr<<"ERROR IN CHANGING FAVOURITE VALUE"<<" "<<e.what()<<endl;
+        discardIfBroken(currentSession, e);
         returnConnection(std::move(currentSession));
         return false;
     }
@@ -463,6 +915,14 @@ bool UrlShortenerDB::deleteLink(const int&id, const string&code){
     std::unique_ptr<mysqlx::Session> currentSession;
     try{
         currentSession = getConnection();
+        // The row and its tombstone (read by every instance serving a link snapshot) go together
+        currentSession->startTransaction();
+        // The link id tells the short code filter whether it ever added this code
+        unsigned int linkId = 0;
+        auto found = executeStatement(*currentSession,
+                                      "SELECT id FROM shortened_links WHERE user_id = ? AND short_code = ? FOR UPDATE",
+                                      {Value(id), Value(code)});
+        if (auto row = found->fetchOne()) linkId = row[0].get<unsigned int>();
         string sql="DELETE FROM shortened_links"
                     " WHERE user_id = ?"
                     " AND short_code = ?;";
@@ -470,17 +930,135 @@ bool UrlShortenerDB::deleteLink(const int&id, const string&code){
             Value(id),
             Value(code),
         };
-        UrlShortenerDB::executeStatement(*currentSession, sql, params); 
+        mysqlx::SqlStatement stmt = currentSession->sql(sql);
+        stmt.bind(params);
+        mysqlx::SqlResult result = stmt.execute();
+        const bool deleted = result.getAffectedItemsCount() != 0;
+        if (deleted) {
+            executeStatement(*currentSession, "INSERT INTO deleted_codes (short_code) VALUES (?)", {Value(code)});
+        }
+        currentSession->commit();
+
+        if (deleted) {
+            // Tombstones past the retention window are no longer needed (a few per call keeps it cheap)
+            try {
+                executeStatement(*currentSession,
+                                 "DELETE FROM deleted_codes WHERE deleted_at < NOW() - INTERVAL ? DAY LIMIT 100",
+                                 {Value(Config::LINK_TOMBSTONE_RETENTION_DAYS)});
+            } catch (const std::exception& e) {
+                cerr << "DB_WARN: Failed to purge old deleted codes: " << e.what() << endl;
+                discardIfBroken(currentSession, e);
+            }
+        }
         returnConnection(std::move(currentSession));
+
+        linkCache->invalidate(code);
+        noteWrite(ReplicaRouter::Key::User, std::to_string(id));
+        noteWrite(ReplicaRouter::Key::ShortCode, code);
+        if (!deleted) {
+            return false; // Not found or not owned by this user
+        }
+        // Only forget codes that were really deleted and that the filter holds, or it would lie
+        if (codeFilterSync) codeFilterSync->removed(linkId, code);
+        if (snapshotTombstones) snapshotTombstones->add(code);
         return true;
     }
-    catch (const mysqlx::Error &e) {
-        cerr<<"ERROR IN DELETING LINK";
+    catch (const std::exception& e) {
+        cerr<<"ERROR IN DELETING LINK: "<<e.what()<<endl;
+        discardIfBroken(currentSession, e);
+        rollbackQuietly(currentSession.get());
         returnConnection(std::move(currentSession));
         return false;
     }
 
 }
+uint64_t UrlShortenerDB::leaseIdBlock(const string& sequence, uint64_t blockSize) {
+    if (!isConnected) return 0;
+    std::unique_ptr<mysqlx::Session> currentSession;
+    uint64_t first = 0;
+    try {
+        currentSession = getConnection();
+        // LAST_INSERT_ID(expr) makes the new upper bound readable on this
+        // session without a transaction; the row lock serializes processes.
+        string sql = "UPDATE id_sequences SET next_value = LAST_INSERT_ID(next_value + ?) WHERE name = ?";
+        executeStatement(*currentSession, sql, {Value(blockSize), Value(sequence)});
+
+        auto result = executeStatement(*currentSession, "SELECT LAST_INSERT_ID()", {});
+        if (auto row = result->fetchOne()) {
+            uint64_t end = row[0].get<uint64_t>();
+            if (end > blockSize) first = end - blockSize;
+        }
+    } catch (const std::exception& e) {
+        cerr << "DB_ERROR: Failed to lease id block for " << sequence << ": " << e.what() << endl;
+        discardIfBroken(currentSession, e);
+    }
+    returnConnection(std::move(currentSession));
+    return first;
+}
+
+unique_ptr<std::vector<string>> UrlShortenerDB::findExistingShortCodes(const std::vector<string>& codes) {
+    if (!isConnected) return nullptr;
+    auto existing = std::make_unique<std::vector<string>>();
+    if (codes.empty()) return existing;
+
+    std::unique_ptr<mysqlx::Session> currentSession;
+    try {
+        currentSession = getConnection();
+        string sql = "SELECT short_code FROM shortened_links WHERE short_code IN (";
+        std::vector<Value> params;
+        params.reserve(codes.size());
+        for (size_t i = 0; i < codes.size(); ++i) {
+            sql += (i == 0) ? "?" : ", ?";
+            params.emplace_back(codes[i]);
+        }
+        sql += ")";
+
+        auto result = executeStatement(*currentSession, sql, params);
+        for (auto row : *result) {
+            existing->push_back(row[0].get<string>());
+        }
+    } catch (const std::exception& e) {
+        cerr << "DB_ERROR: Failed to check short codes: " << e.what() << endl;
+        discardIfBroken(currentSession, e);
+        existing = nullptr;
+    }
+    returnConnection(std::move(currentSession));
+    return existing;
+}
+
+// expires_at as stored: the requested date, or LINK_EXPIRED_IN days from now
+string UrlShortenerDB::linkExpiry(const ShortenedLink& link) {
+    if (!link.expires_at.empty()) return link.expires_at;
+
+    auto now = std::chrono::system_clock::now();
+    now += std::chrono::hours(24 * Config::LINK_EXPIRED_IN);
+    std::time_t t = std::chrono::system_clock::to_time_t(now);
+    struct tm ltm;
+    localtime_r(&t, &ltm);
+    char buffer[20];
+    std::strftime(buffer, sizeof(buffer), "%Y-%m-%d %H:%M:%S", &ltm);
+    return buffer;
+}
+
+// Bookkeeping after a link row is committed
+void UrlShortenerDB::rememberCreatedLink(const ShortenedLink& link, unsigned int id, const string& expires_at) {
+    // Populate the redirect cache so the first click does not hit the DB
+    CachedLink cached;
+    cached.id = id;
+    cached.original_url = link.original_url;
+    cached.user_id = link.user_id ? *link.user_id : 0;
+    cached.expires_at = expires_at;
+    cached.expires_epoch = parseTimestamp(expires_at);
+    if (linkDedupe && link.url_hash != 0) {
+        linkDedupe->remember(LinkDedupeIndex::keyFor(cached.user_id, link.guest_identifier, link.url_hash),
+                             link.short_code, cached.expires_epoch);
+    }
+    linkCache->put(link.short_code, std::move(cached));
+    if (codeFilterSync) codeFilterSync->added(id, link.short_code);
+    noteWrite(ReplicaRouter::Key::ShortCode, link.short_code);
+    if (link.user_id) noteWrite(ReplicaRouter::Key::User, std::to_string(*link.user_id));
+}
+
 bool UrlShortenerDB::createLink(const ShortenedLink& link) {
     if (!isConnected) return false;
     std::unique_ptr<mysqlx::Session> currentSession;
@@ -489,39 +1067,34 @@ bool UrlShortenerDB::createLink(const ShortenedLink& link) {
         currentSession = getConnection();
 
         string sql = "INSERT INTO shortened_links "
-                     "(original_url, short_code, user_id, guest_identifier, expires_at, created_at, updated_at) "
-                     "VALUES (?, ?, ?, ?, ?, NOW(), NOW())";
+                     "(original_url, short_code, user_id, guest_identifier, expires_at, url_hash, created_at, updated_at) "
+                     "VALUES (?, ?, ?, ?, ?, ?, NOW(), NOW())";
         
         // Handle optional user_id (Authenticated Link Creation)
         Value user_id_val = link.user_id ? Value(*link.user_id) : Value(nullptr);
         
-        // Calculate expiration date
-        auto now = std::chrono::system_clock::now();
-        now += std::chrono::hours(24 * Config::LINK_EXPIRED_IN);  
-        std::time_t t = std::chrono::system_clock::to_time_t(now);
-        char buffer[20];
-        std::strftime(buffer, sizeof(buffer), "%Y-%m-%d %H:%M:%S", std::localtime(&t));
-        
-        std::string expires_at = !link.expires_at.empty() ? link.expires_at : std::string(buffer);
-        
         // Handle optional expires_at (Link Expiration)
-        Value expires_at_val = Value(expires_at);
+        std::string expires_at = linkExpiry(link);
 
         std::vector<Value> params = {
             Value(link.original_url),
             Value(link.short_code),
             user_id_val,
             Value(link.guest_identifier),
-            expires_at_val
+            Value(expires_at),
+            link.url_hash ? Value(link.url_hash) : Value(nullptr)
         };
 
-        currentSession->sql(sql).bind(params).execute();
+        mysqlx::SqlResult result = currentSession->sql(sql).bind(params).execute();
         returnConnection(std::move(currentSession));
+
+        rememberCreatedLink(link, static_cast<unsigned int>(result.getAutoIncrementValue()), expires_at);
         return true;
 
-    } catch (const mysqlx::Error &e) {
+    } catch (const std::exception& e) {
         std::string err_msg = e.what();
         std::cerr << "DB_ERROR: " << err_msg << std::endl;
+        discardIfBroken(currentSession, e);
 
         // Detect duplicate key by checking text in the error message
         if (err_msg.find("Duplicate entry") != std::string::npos) {
@@ -531,6 +1104,91 @@ bool UrlShortenerDB::createLink(const ShortenedLink& link) {
         return false;
     }
 }
+
+// Group commit: one transaction, one multi-row INSERT for the whole batch
+bool UrlShortenerDB::createLinks(const std::vector<const ShortenedLink*>& links, std::vector<LinkInsertResult>& results) {
+    results.assign(links.size(), LinkInsertResult::Failed);
+    if (!isConnected) return false;
+    if (links.empty()) return true;
+    std::unique_ptr<mysqlx::Session> currentSession;
+
+    try {
+        currentSession = getConnection();
+        currentSession->startTransaction();
+
+        // Codes that already exist are per-row duplicates. FOR UPDATE also
+        // gap-locks the free ones, so nobody can insert them before we commit.
+        string inList;
+        std::vector<Value> codes;
+        codes.reserve(links.size());
+        for (size_t i = 0; i < links.size(); ++i) {
+            inList += i ? ", ?" : "?";
+            codes.emplace_back(links[i]->short_code);
+        }
+        auto existing = executeStatement(*currentSession,
+            "SELECT short_code FROM shortened_links WHERE short_code IN (" + inList + ") FOR UPDATE", codes);
+
+        std::unordered_set<string> taken;
+        for (auto row : *existing) {
+            taken.insert(row[0].get<string>());
+        }
+
+        // First request for a free code wins, later ones in the batch are duplicates too
+        std::vector<size_t> toInsert;
+        std::vector<string> expiries(links.size());
+        string sql = "INSERT INTO shortened_links "
+                     "(original_url, short_code, user_id, guest_identifier, expires_at, url_hash, created_at, updated_at) VALUES ";
+        string insertedList;
+        std::vector<Value> params;
+        std::vector<Value> insertedCodes;
+        for (size_t i = 0; i < links.size(); ++i) {
+            const ShortenedLink& link = *links[i];
+            if (!taken.insert(link.short_code).second) {
+                results[i] = LinkInsertResult::Duplicate;
+                continue;
+            }
+            expiries[i] = linkExpiry(link);
+            sql += toInsert.empty() ? "(?, ?, ?, ?, ?, ?, NOW(), NOW())" : ", (?, ?, ?, ?, ?, ?, NOW(), NOW())";
+            insertedList += toInsert.empty() ? "?" : ", ?";
+            params.emplace_back(link.original_url);
+            params.emplace_back(link.short_code);
+            params.push_back(link.user_id ? Value(*link.user_id) : Value(nullptr));
+            params.emplace_back(link.guest_identifier);
+            params.emplace_back(expiries[i]);
+            params.push_back(link.url_hash ? Value(link.url_hash) : Value(nullptr));
+            insertedCodes.emplace_back(link.short_code);
+            toInsert.push_back(i);
+        }
+
+        std::unordered_map<string, unsigned int> ids;
+        if (!toInsert.empty()) {
+            executeStatement(*currentSession, sql, params);
+
+            // Ids of a multi-row INSERT need not be consecutive (innodb_autoinc_lock_mode=2), read them back
+            auto inserted = executeStatement(*currentSession,
+                "SELECT id, short_code FROM shortened_links WHERE short_code IN (" + insertedList + ")", insertedCodes);
+            for (auto row : *inserted) {
+                ids[row[1].get<string>()] = row[0].get<unsigned int>();
+            }
+        }
+        currentSession->commit();
+        returnConnection(std::move(currentSession));
+
+        for (size_t i : toInsert) {
+            results[i] = LinkInsertResult::Created;
+            rememberCreatedLink(*links[i], ids[links[i]->short_code], expiries[i]);
+        }
+        return true;
+
+    } catch (const std::exception& e) {
+        cerr << "DB_ERROR: Batched link insert failed: " << e.what() << endl;
+        discardIfBroken(currentSession, e);
+        rollbackQuietly(currentSession.get());
+        returnConnection(std::move(currentSession));
+        results.assign(links.size(), LinkInsertResult::Failed);
+        return false;
+    }
+}
 // Implements Link Analytics (Click Tracking)
 bool UrlShortenerDB::incrementLinkClicks(unsigned int link_id) {
     if (!isConnected) return false;
@@ -541,54 +1199,166 @@ bool UrlShortenerDB::incrementLinkClicks(unsigned int link_id) {
         currentSession->sql(sql).bind(Value(link_id)).execute();
         returnConnection(std::move(currentSession));
         return true;
-    } catch (const mysqlx::Error& e) {
+    } catch (const std::exception& e) {
         cerr << "DB_ERROR: Failed to increment clicks: " << e.what() << endl;
+        discardIfBroken(currentSession, e);
+        returnConnection(std::move(currentSession));
+        return false;
+    }
+}
+
+// Applies coalesced click deltas with one multi-row UPDATE per chunk
+bool UrlShortenerDB::addLinkClicks(const std::vector<std::pair<unsigned int, unsigned long long>>& deltas) {
+    if (!isConnected) return false;
+    if (deltas.empty()) return true;
+    const size_t CHUNK_SIZE = 500;
+    std::unique_ptr<mysqlx::Session> currentSession;
+    try {
+        currentSession = getConnection();
+        // All chunks or none: the caller re-queues every delta on failure
+        currentSession->startTransaction();
+
+        for (size_t start = 0; start < deltas.size(); start += CHUNK_SIZE) {
+            size_t end = std::min(deltas.size(), start + CHUNK_SIZE);
+
+            string sql = "UPDATE shortened_links SET clicks = clicks + CASE id";
+            string inList;
+            std::vector<Value> params;
+            params.reserve((end - start) * 3);
+            for (size_t i = start; i < end; ++i) {
+                sql += " WHEN ? THEN ?";
+                params.emplace_back(deltas[i].first);
+                params.emplace_back(deltas[i].second);
+                inList += (i == start) ? "?" : ", ?";
+            }
+            sql += " ELSE 0 END, updated_at = NOW() WHERE id IN (" + inList + ")";
+            for (size_t i = start; i < end; ++i) {
+                params.emplace_back(deltas[i].first);
+            }
+
+            executeStatement(*currentSession, sql, params);
+        }
+        currentSession->commit();
+        returnConnection(std::move(currentSession));
+        return true;
+    } catch (const std::exception& e) {
+        cerr << "DB_ERROR: Failed to flush link clicks: " << e.what() << endl;
+        discardIfBroken(currentSession, e);
+        rollbackQuietly(currentSession.get());
         returnConnection(std::move(currentSession));
         return false;
     }
 }
 
 unique_ptr<std::vector<ShortenedLink>> UrlShortenerDB::getLinksByUserId(unsigned int user_id) {
-    if (!isConnected) return nullptr;
+    auto links = std::make_unique<std::vector<ShortenedLink>>();
+    bool ok = forEachUserLink(user_id, nullptr, 0, [&links](const ShortenedLink& row) {
+        ShortenedLink link;
+        link.id = row.id;
+        link.original_url = row.original_url;
+        link.short_code = row.short_code;
+        link.expires_at = row.expires_at;
+        link.clicks = row.clicks;
+        link.created_at = row.created_at;
+        links->push_back(std::move(link));
+        return true;
+    });
+    // Same as before: an empty list when the query failed
+    if (!ok) links->clear();
+    return links;
+}
+
+// Keyset pagination on ix_user_created_id (user_id, created_at, id): the
+// page starts right after the cursor row, no OFFSET scan.
+bool UrlShortenerDB::forEachUserLink(unsigned int user_id, const LinkCursor* after, size_t limit,
+                                     const std::function<bool(const ShortenedLink&)>& onRow) {
+    if (!isConnected) return false;
     std::unique_ptr<mysqlx::Session> currentSession;
-    unique_ptr<std::vector<ShortenedLink>> links = nullptr;
+    ReplicaRouter::Replica* replica = nullptr;
+    bool ok = false;
 
     try {
-        currentSession = getConnection();
-        string sql = "SELECT id, original_url, short_code, expires_at, clicks, created_at FROM shortened_links WHERE user_id = ? ORDER BY created_at DESC";
-        auto result = executeStatement(*currentSession, sql, {Value(user_id)}); 
-        
-        links = std::make_unique<std::vector<ShortenedLink>>();
+        currentSession = getReadConnection(replica, ReplicaRouter::Key::User, std::to_string(user_id));
+        string sql = "SELECT id, original_url, short_code, expires_at, clicks, created_at FROM shortened_links WHERE user_id = ?";
+        std::vector<Value> params = {Value(user_id)};
+        if (after) {
+            sql += " AND (created_at < ? OR (created_at = ? AND id < ?))";
+            params.emplace_back(after->created_at);
+            params.emplace_back(after->created_at);
+            params.emplace_back(after->id);
+        }
+        sql += " ORDER BY created_at DESC, id DESC";
+        if (limit > 0) {
+            sql += " LIMIT ?";
+            params.emplace_back(static_cast<unsigned long long>(limit));
+        }
+        auto result = executeStatement(*currentSession, sql, params);
 
-        for (auto row : *result) {
-            ShortenedLink link;
+        // Rows are decoded one at a time into the same object; nothing is materialized
+        ShortenedLink link;
+        ok = true;
+        while (auto row = result->fetchOne()) {
             link.id = row[0].get<unsigned int>();
             link.original_url = row[1].get<string>();
             link.short_code = row[2].get<string>();
-            link.expires_at = row[3].get<string>();
+            link.expires_at = row[3].isNull() ? "" : row[3].get<string>();
             link.clicks = row[4].get<unsigned int>();
             link.created_at = row[5].get<string>();
-            links->push_back(std::move(link));
+            if (!onRow(link)) break;
         }
 
     } catch (const std::exception& e) {
         cerr << "DB_ERROR: Failed to fetch user links: " << e.what() << endl;
+        discardIfBroken(currentSession, e, replica);
+        ok = false;
     }
-    returnConnection(std::move(currentSession));
-    return links;
+    returnReadConnection(std::move(currentSession), replica);
+    return ok;
 }
 
 unique_ptr<ShortenedLink> UrlShortenerDB::getLinkByShortCode(const string& code) {
     if (!isConnected) return nullptr;
     std::unique_ptr<mysqlx::Session> currentSession;
+    ReplicaRouter::Replica* replica = nullptr;
     unique_ptr<ShortenedLink> link = nullptr;
 
+    // Serve hot links from memory without a pool checkout
+    if (auto cached = linkCache->get(code)) {
+        link = std::make_unique<ShortenedLink>();
+        link->id = cached->id;
+        link->original_url = cached->original_url;
+        link->short_code = code;
+        if (cached->user_id != 0) {
+            link->user_id = std::make_unique<unsigned int>(cached->user_id);
+        }
+        link->expires_at = cached->expires_at;
+        return link;
+    }
+
+    // Long tail: the mmap'd snapshot answers without a pool checkout, even
+    // while MySQL is slow. Tombstoned codes were deleted after the snapshot.
+    SnapshotLink snapshotLink;
+    if (linkSnapshot && linkSnapshot->lookup(code, snapshotLink) && !snapshotTombstones->contains(code)) {
+        link = std::make_unique<ShortenedLink>();
+        link->id = snapshotLink.id;
+        link->original_url = std::move(snapshotLink.original_url);
+        link->short_code = code;
+        if (snapshotLink.user_id != 0) {
+            link->user_id = std::make_unique<unsigned int>(snapshotLink.user_id);
+        }
+        link->expires_at = formatTimestamp(snapshotLink.expires_epoch);
+        return link;
+    }
+
+    // Definitely unknown code (bot scans, fresh generated codes): skip the DB
+    if (codeFilter && !codeFilter->mightContain(code)) {
+        return nullptr;
+    }
+
     try {
-        currentSession = getConnection();
+        currentSession = getReadConnection(replica, ReplicaRouter::Key::ShortCode, code);
         // Check for the code AND ensure it hasn't expired (Link Expiration)
-        string sql = "SELECT id, original_url, short_code, user_id, expires_at, clicks FROM shortened_links "
-                     "WHERE short_code = ? AND (expires_at IS NULL OR expires_at > NOW())";
-        auto result = executeStatement(*currentSession, sql, {Value(code)}); 
+        auto result = executeCached(poolOf(replica), *currentSession, StatementCache::Query::LinkByCode, Value(code));
         
         if (auto row = result->fetchOne()) {
             link = std::make_unique<ShortenedLink>();
@@ -602,114 +1372,233 @@ unique_ptr<ShortenedLink> UrlShortenerDB::getLinkByShortCode(const string& code)
                 link->user_id = std::make_unique<unsigned int>(row[3].get<unsigned int>());
             }
             
-            link->expires_at = row[4].get<string>();
+            link->expires_at = row[4].isNull() ? "" : row[4].get<string>();
             link->clicks = row[5].get<unsigned int>(); // Link Analytics
+
+            CachedLink cached;
+            cached.id = link->id;
+            cached.original_url = link->original_url;
+            cached.user_id = link->user_id ? *link->user_id : 0;
+            cached.expires_at = link->expires_at;
+            cached.expires_epoch = parseTimestamp(link->expires_at);
+            linkCache->put(code, std::move(cached));
         }
 
     } catch (const std::exception& e) {
         cerr << "DB_ERROR: Failed to get link: " << e.what() << endl;
+        discardIfBroken(currentSession, e, replica);
     }
-    returnConnection(std::move(currentSession));
+    returnReadConnection(std::move(currentSession), replica);
     return link;
 }
 
-// --- Quota Management ---
-bool UrlShortenerDB::isQuotaLimitEnabled() {
-    if (!isConnected) return true; // Default to true if DB fails (fail-safe)
+LinkDedupeIndex::KeyLock UrlShortenerDB::lockLinkUrl(const ShortenedLink& link) {
+    if (!linkDedupe || link.url_hash == 0) return {};
+    return linkDedupe->lock(LinkDedupeIndex::keyFor(link.user_id ? *link.user_id : 0, link.guest_identifier, link.url_hash));
+}
+
+unique_ptr<ShortenedLink> UrlShortenerDB::findDuplicateLink(const ShortenedLink& link) {
+    if (!linkDedupe || link.url_hash == 0 || !isConnected) return nullptr;
+    const unsigned int ownerId = link.user_id ? *link.user_id : 0;
+    const uint64_t key = LinkDedupeIndex::keyFor(ownerId, link.guest_identifier, link.url_hash);
+
+    // Hint from memory, confirmed through the redirect path (cache, snapshot, DB):
+    // the code may have been deleted, or the hash may belong to another URL
+    LinkDedupeIndex::Entry entry;
+    if (linkDedupe->find(key, entry)) {
+        auto existing = getLinkByShortCode(entry.code);
+        if (existing && existing->original_url == link.original_url &&
+            (existing->user_id ? *existing->user_id : 0) == ownerId) {
+            std::time_t expires = parseTimestamp(existing->expires_at);
+            if (expires == 0 || expires > std::time(nullptr)) return existing;
+        }
+        linkDedupe->forget(key);
+    }
+
     std::unique_ptr<mysqlx::Session> currentSession;
-    bool enabled = true;
-    
+    unique_ptr<ShortenedLink> found = nullptr;
     try {
+        // Primary only: the link may have been created a moment ago
         currentSession = getConnection();
-        string sql = "SELECT setting_value FROM global_settings WHERE setting_key = 'MAX_LINK_LIMIT_ENABLED'";
-        auto result = executeStatement(*currentSession, sql, {}); 
-        
+        string sql = "SELECT id, short_code, expires_at FROM shortened_links"
+                     " WHERE url_hash = ? AND original_url = ?";
+        std::vector<Value> params = {Value(link.url_hash), Value(link.original_url)};
+        if (link.user_id) {
+            sql += " AND user_id = ?";
+            params.emplace_back(*link.user_id);
+        } else {
+            sql += " AND user_id IS NULL AND guest_identifier = ?";
+            params.emplace_back(link.guest_identifier);
+        }
+        sql += " AND (expires_at IS NULL OR expires_at > NOW()) ORDER BY id DESC LIMIT 1";
+
+        auto result = executeStatement(*currentSession, sql, params);
         if (auto row = result->fetchOne()) {
-            string value = row[0].get<string>();
-            enabled = (value == "true");
+            found = std::make_unique<ShortenedLink>();
+            found->id = row[0].get<unsigned int>();
+            found->short_code = row[1].get<string>();
+            found->expires_at = row[2].isNull() ? "" : row[2].get<string>();
+            found->original_url = link.original_url;
+            if (link.user_id) found->user_id = std::make_unique<unsigned int>(*link.user_id);
+            found->guest_identifier = link.guest_identifier;
+            found->url_hash = link.url_hash;
         }
     } catch (const std::exception& e) {
-        cerr << "DB_ERROR: Failed to read global setting: " << e.what() << endl;
+        cerr << "DB_ERROR: Dedupe lookup failed: " << e.what() << endl;
+        discardIfBroken(currentSession, e);
     }
     returnConnection(std::move(currentSession));
-    return enabled; 
+
+    if (found) linkDedupe->remember(key, found->short_code, parseTimestamp(found->expires_at));
+    return found;
+}
+
+// --- Quota Management ---
+bool UrlShortenerDB::isQuotaLimitEnabled() {
+    if (!isConnected) return true; // Default to true if DB fails (fail-safe)
+    return getSettings()->maxLinkLimitEnabled;
 }
 
 std::string UrlShortenerDB::getConfig(std::string key){
     if (!isConnected) throw runtime_error("Database not connected");
+    auto current = getSettings();
+    auto it = current->values.find(key);
+    if (it == current->values.end()) {
+        cerr<<"DB_ERROR: FAILED TO GET THE CONFIG FOR KEY: "<<key<<endl;
+        return "invalid request"; // Use a specific error value
+    }
+    return it->second;
+}
+
+// --- Global Settings ---
+std::shared_ptr<const GlobalSettingsSnapshot> UrlShortenerDB::getSettings() const {
+    if (!settings) return std::make_shared<const GlobalSettingsSnapshot>(); // Defaults before connect()
+    return settings->current();
+}
+
+bool UrlShortenerDB::reloadGlobalSettings() {
+    return settings && settings->reload();
+}
+
+// Always read from the primary: an admin reload must see the value just written
+unique_ptr<std::vector<GlobalSetting>> UrlShortenerDB::getGlobalSettings() {
+    if (!isConnected) return nullptr;
     std::unique_ptr<mysqlx::Session> currentSession;
-    std::string value = "";
+    unique_ptr<std::vector<GlobalSetting>> rows = nullptr;
 
-    try
-    {
+    try {
         currentSession = getConnection();
-        string sql = "use database ";
-        sql+=Config::DB_NAME;
-        auto result = executeStatement(*currentSession, sql, {}); 
-        
-        sql = "SELECT setting_value FROM global_settings WHERE setting_key = ?";
-        result = executeStatement(*currentSession, sql, {Value(key)}); 
-        
-        if (auto row = result->fetchOne()) {
-            value = row[0].get<string>();
+        string sql = "SELECT id, setting_key, setting_value, description FROM global_settings";
+        auto result = executeStatement(*currentSession, sql, {});
+
+        rows = std::make_unique<std::vector<GlobalSetting>>();
+        for (auto row : *result) {
+            GlobalSetting setting;
+            setting.id = row[0].get<unsigned int>();
+            setting.setting_key = row[1].get<string>();
+            setting.setting_value = row[2].get<string>();
+            setting.description = row[3].isNull() ? "" : row[3].get<string>();
+            rows->push_back(std::move(setting));
         }
-    }
-    catch(const std::exception& e)
-    {
-        cerr<<"DB_ERROR: FAILED TO GET THE CONFIG FOR KEY: "<<key<<" with error"<<e.what()<<endl;
-        value = "invalid request"; // Use a specific error value
+    } catch (const std::exception& e) {
+        cerr << "DB_ERROR: Failed to load global settings: " << e.what() << endl;
+        discardIfBroken(currentSession, e);
+        rows = nullptr;
     }
     returnConnection(std::move(currentSession));
-    return value;
-} 
+    return rows;
+}
 
+// Enforced in memory (GuestQuotaCounter); guest_daily_quotas is updated in the background
 bool UrlShortenerDB::checkAndUpdateGuestQuota(const string& guest_identifier, const string& today_date) {
-    if (!isConnected) return false;
+    if (!isConnected || !guestQuota) return false;
+
+    // From the in-memory settings snapshot, no extra round-trip
+    const unsigned int MAX_GUEST_LINKS_PER_DAY = getSettings()->maxGuestLinksPerDay;
+    if (!guestQuota->tryConsume(guest_identifier, today_date, MAX_GUEST_LINKS_PER_DAY)) {
+        cerr << "DB_CHECK: Quota limit reached (" << MAX_GUEST_LINKS_PER_DAY << ") for " << guest_identifier << endl;
+        return false; // Quota exceeded
+    }
+    return true;
+}
+
+unique_ptr<std::vector<GuestQuota>> UrlShortenerDB::getGuestQuotas(const string& date) {
+    if (!isConnected) return nullptr;
     std::unique_ptr<mysqlx::Session> currentSession;
-    bool success = false;
+    unique_ptr<std::vector<GuestQuota>> quotas = nullptr;
 
     try {
         currentSession = getConnection();
+        string sql = "SELECT id, guest_identifier, links_created FROM guest_daily_quotas WHERE quota_date = ?";
+        auto result = executeStatement(*currentSession, sql, {Value(date)});
 
-        // SELECT current quota
-        string select_sql = "SELECT links_created FROM guest_daily_quotas WHERE guest_identifier = ? AND quota_date = ?";
-        auto result = executeStatement(*currentSession, select_sql, {Value(guest_identifier), Value(today_date)});
-        
-        unsigned int links_created_today = 0;
-        if (auto row = result->fetchOne()) {
-            links_created_today = row[0].get<unsigned int>();
-        }
-        
-        int MAX_GUEST_LINKS_PER_DAY = 5;
-        std::string config_val = getConfig(*currentSession, "MAX_GUEST_LINKS_PER_DAY");
-        
-        if (config_val != "invalid request" && !config_val.empty()) {
-            try {
-                MAX_GUEST_LINKS_PER_DAY = std::stoi(config_val);
-            } catch (const std::exception&) {
-                cerr << "DB_CONFIG_ERROR: Failed to convert MAX_GUEST_LINKS_PER_DAY to int." << endl;
-            }
-        } else {
-            cerr<<"DB_CONFIG_ERROR: Unable to find config for key MAX_GUEST_LINKS_PER_DAY, using default 5."<<endl;
+        quotas = std::make_unique<std::vector<GuestQuota>>();
+        for (auto row : *result) {
+            GuestQuota quota;
+            quota.id = row[0].get<unsigned int>();
+            quota.guest_identifier = row[1].get<string>();
+            quota.quota_date = date;
+            quota.links_created = row[2].get<unsigned int>();
+            quotas->push_back(std::move(quota));
         }
+    } catch (const std::exception& e) {
+        cerr << "DB_ERROR: Failed to load guest quotas: " << e.what() << endl;
+        discardIfBroken(currentSession, e);
+        quotas = nullptr;
+    }
+    returnConnection(std::move(currentSession));
+    return quotas;
+}
 
-        if (links_created_today >= MAX_GUEST_LINKS_PER_DAY ) {
-            cerr << "DB_CHECK: Quota limit reached (" << links_created_today << "/" << MAX_GUEST_LINKS_PER_DAY << ") for " << guest_identifier << endl;
-            success = false; // Quota exceeded
-        } else {
-            // INSERT or UPDATE quota (ON DUPLICATE KEY UPDATE)
-            string upsert_sql = "INSERT INTO guest_daily_quotas (guest_identifier, quota_date, links_created, created_at, updated_at) "
-                                "VALUES (?, ?, 1, NOW(), NOW()) "
-                                "ON DUPLICATE KEY UPDATE links_created = links_created + 1, updated_at = NOW()";
-            
-            currentSession->sql(upsert_sql).bind(Value(guest_identifier)).bind(Value(today_date)).execute();
-            success = true; // Quota check passed and updated
+// Adds counted links per guest with one multi-row upsert per chunk, then reads the stored totals back
+bool UrlShortenerDB::addGuestQuotaUsage(const string& date, const std::vector<std::pair<string, unsigned int>>& deltas,
+                                        std::unordered_map<string, unsigned int>& totals) {
+    if (!isConnected) return false;
+    if (deltas.empty()) return true;
+    const size_t CHUNK_SIZE = 500;
+    std::unique_ptr<mysqlx::Session> currentSession;
+    try {
+        currentSession = getConnection();
+        // All chunks or none: the caller keeps every delta for the next flush on failure
+        currentSession->startTransaction();
+
+        for (size_t start = 0; start < deltas.size(); start += CHUNK_SIZE) {
+            size_t end = std::min(deltas.size(), start + CHUNK_SIZE);
+
+            string sql = "INSERT INTO guest_daily_quotas (guest_identifier, quota_date, links_created, created_at, updated_at) VALUES ";
+            string inList;
+            std::vector<Value> params;
+            std::vector<Value> guests;
+            params.reserve((end - start) * 3);
+            guests.reserve(end - start + 1);
+            guests.emplace_back(date);
+            for (size_t i = start; i < end; ++i) {
+                sql += (i == start) ? "(?, ?, ?, NOW(), NOW())" : ", (?, ?, ?, NOW(), NOW())";
+                inList += (i == start) ? "?" : ", ?";
+                params.emplace_back(deltas[i].first);
+                params.emplace_back(date);
+                params.emplace_back(deltas[i].second);
+                guests.emplace_back(deltas[i].first);
+            }
+            sql += " ON DUPLICATE KEY UPDATE links_created = links_created + VALUES(links_created), updated_at = NOW()";
+            executeStatement(*currentSession, sql, params);
+
+            auto result = executeStatement(*currentSession,
+                "SELECT guest_identifier, links_created FROM guest_daily_quotas WHERE quota_date = ? AND guest_identifier IN (" + inList + ")",
+                guests);
+            for (auto row : *result) {
+                totals[row[0].get<string>()] = row[1].get<unsigned int>();
+            }
         }
-
-    } catch (const mysqlx::Error& e) {
-        cerr << "DB_ERROR: Quota check failed: " << e.what() << endl;
-        success = false;
+        currentSession->commit();
+        returnConnection(std::move(currentSession));
+        return true;
+    } catch (const std::exception& e) {
+        cerr << "DB_ERROR: Failed to flush guest quotas: " << e.what() << endl;
+        discardIfBroken(currentSession, e);
+        rollbackQuietly(currentSession.get());
+        totals.clear(); // Read inside the rolled-back transaction
+        returnConnection(std::move(currentSession));
+        return false;
     }
-    returnConnection(std::move(currentSession));
-    return success;
-}
\ No newline at end of file
+}
@@ -8,10 +8,29 @@
 #include <mutex>
 #include <queue>
 #include <condition_variable>
+#include <functional>
+#include <shared_mutex>
+#include <unordered_set>
+#include <unordered_map>
+#include <array>
+#include <atomic>
+#include <utility>
 
 #include <mysqlx/xdevapi.h>
 
 #include "Config.h"
+#include "LinkCache.h"
+#include "SessionCache.h"
+#include "StatementCache.h"
+#include "ConnectionPool.h"
+#include "ReplicaRouter.h"
+#include "GlobalSettings.h"
+#include "GuestQuotaCounter.h"
+#include "ShortCodeFilter.h"
+#include "ShortCodeFilterSync.h"
+#include "LinkSnapshot.h"
+#include "LinkTombstones.h"
+#include "LinkDedupe.h"
 
 // --- DTO Headers ---
 #include "Modals/UserDTO.h"
@@ -19,17 +38,82 @@
 #include "Modals/ShortenedLink.h"
 #include "Modals/QuotaDTO.h"
 #include "Modals/GlobalSettingDTO.h"
+#include "Modals/EndpointStatDTO.h"
 
 
+// Keyset position in a user's link list: the last row of the previous page
+struct LinkCursor {
+    std::string created_at; // YYYY-MM-DD HH:MM:SS
+    unsigned int id = 0;
+};
+
+// Per-row outcome of a batched link insert
+enum class LinkInsertResult { Created, Duplicate, Failed };
+
+// Every public method is safe to call concurrently: each call checks out its
+// own session from the pool and returns it before leaving.
 class UrlShortenerDB {
 private:
-    std::queue<std::unique_ptr<mysqlx::Session>> connectionPool;
-    std::mutex poolMutex;
-    std::condition_variable poolCv;
-    int poolSize = 10; 
-    
+    // Elastic, health-checked session pool (created in connect())
+    std::unique_ptr<ConnectionPool> pool;
+
     std::unique_ptr<mysqlx::Session> getConnection();
-    bool isConnected = false;
+
+    // Read-only replica pools (nullptr when DB_REPLICAS is empty)
+    std::unique_ptr<ReplicaRouter> replicaRouter;
+    // Session for a pure read: a replica, or the primary when there is none or
+    // the row was written recently. `replica` is nullptr for the primary.
+    std::unique_ptr<mysqlx::Session> getReadConnection(ReplicaRouter::Replica*& replica,
+                                                       ReplicaRouter::Key kind, const std::string& id);
+    void returnReadConnection(std::unique_ptr<mysqlx::Session> session, ReplicaRouter::Replica* replica);
+    // Closes `session` instead of pooling it when `e` was a connection-level error; the
+    // return*Connection() that follows is then a no-op
+    void discardIfBroken(std::unique_ptr<mysqlx::Session>& session, const std::exception& e,
+                         ReplicaRouter::Replica* replica = nullptr);
+    ConnectionPool& poolOf(ReplicaRouter::Replica* replica) { return replica ? *replica->pool : *pool; }
+    void noteWrite(ReplicaRouter::Key kind, const std::string& id) {
+        if (replicaRouter) replicaRouter->noteWrite(kind, id);
+    }
+    std::atomic<bool> isConnected{false};
+
+    // Reusable lookup statements; the pool keeps one cache per session
+    StatementCacheStats statementStats;
+    std::unique_ptr<mysqlx::RowResult> executeCached(mysqlx::Session& currentSession,
+                                                     StatementCache::Query query, const mysqlx::Value& key);
+    std::unique_ptr<mysqlx::RowResult> executeCached(ConnectionPool& owner, mysqlx::Session& currentSession,
+                                                     StatementCache::Query query, const mysqlx::Value& key);
+
+    // Shared by createLink and createLinks
+    static std::string linkExpiry(const ShortenedLink& link);
+    void rememberCreatedLink(const ShortenedLink& link, unsigned int id, const std::string& expires_at);
+
+    // Guest link quota counted in memory, written back in batches (created in connect())
+    std::unique_ptr<GuestQuotaCounter> guestQuota;
+
+    // Read-through cache for the redirect path (created in connect())
+    std::unique_ptr<LinkCache> linkCache;
+
+    // Owner + long URL -> short code hints (nullptr unless DEDUPE_LINKS)
+    std::unique_ptr<LinkDedupeIndex> linkDedupe;
+
+    // Snapshot of global_settings (created in connect(), first loaded by setupDatabase())
+    std::unique_ptr<GlobalSettingsCache> settings;
+
+    // Token -> session cache for AuthMiddleware, including known-bad tokens (created in connect())
+    std::unique_ptr<SessionCache> sessionCache;
+
+    // Existence filter of all short codes (nullptr when disabled)
+    std::unique_ptr<ShortCodeFilter> codeFilter;
+    // Adds codes created by other processes to the filter (nullptr when disabled)
+    std::unique_ptr<ShortCodeFilterSync> codeFilterSync;
+
+    // Immutable mmap'd snapshot plus the delta overlay: codes deleted since
+    // the snapshot was built (by any instance, see deleted_codes) must no
+    // longer be served from it. Links created since then are simply not in
+    // the snapshot and fall through to the DB.
+    std::unique_ptr<LinkSnapshot> linkSnapshot;
+    std::unique_ptr<LinkTombstones> snapshotTombstones;
+    static constexpr std::time_t SNAPSHOT_CLOCK_SKEW_SECONDS = 300;
 
     std::unique_ptr<mysqlx::RowResult> executeStatement(
         const std::string& sql, 
@@ -42,11 +126,23 @@ public:
 
     bool connect();
     bool setupDatabase();
+    bool loadShortCodeFilter(); // Streams shortened_links into the filter
+    bool openLinkSnapshot(const std::string& path);
+
+    // Streams (id, short_code) of every link with id > after_id, in id order (filter sync)
+    bool forEachShortCodeAfter(unsigned int after_id, const std::function<void(unsigned int, const std::string&)>& callback);
+    // Streams (id, short_code) of deleted_codes rows with id > after_id deleted at or after `since`
+    bool forEachDeletedCode(uint64_t after_id, std::time_t since,
+                            const std::function<void(uint64_t, const std::string&)>& callback);
+    // Streams every non-expired link (used by the snapshot generator)
+    bool forEachLiveLink(const std::function<void(const ShortenedLink&)>& callback);
 
     // --- Time/Date Helpers ---
     static std::string getTodayDate();
     static std::string getCurrentTimestamp();
     static std::string getFutureTimestamp(int days);
+    static std::time_t parseTimestamp(const std::string& timestamp); // 0 if empty/invalid
+    static std::string formatTimestamp(std::time_t epoch); // "" for 0
 
     // --- User & Session Methods ---
     bool createUser(const User& user); 
@@ -59,25 +155,62 @@ public:
     
     // Token Expiration / Logout
     bool deleteSession(const std::string& token); 
+    // Marks revoked_at, the row stays until it expires. For a signed token pass its
+    // user and expiry: the row is then kept (or re-created) at least that long.
+    bool revokeSession(const std::string& token, unsigned int user_id = 0, std::time_t token_expires = 0);
+    // Revoked, not yet expired signed tokens (for RevocationList); nullptr on failure
+    std::unique_ptr<std::vector<std::string>> getRevokedSessionTokens();
+    // Deletes up to `limit` expired session rows; returns how many, -1 on failure
+    long long purgeExpiredSessions(size_t limit);
 
     // --- Link Creation & Retrieval ---
+    // Reserves blockSize ids from id_sequences; returns the first id, 0 on failure
+    uint64_t leaseIdBlock(const std::string& sequence, uint64_t blockSize);
+    // Which of the given codes already exist (one IN (...) query); nullptr on failure
+    std::unique_ptr<std::vector<std::string>> findExistingShortCodes(const std::vector<std::string>& codes);
     bool createLink(const ShortenedLink& link);
+    // Inserts a batch in one transaction (group commit). results[i] is the
+    // outcome of links[i]; false if the whole transaction failed.
+    bool createLinks(const std::vector<const ShortenedLink*>& links, std::vector<LinkInsertResult>& results);
     std::unique_ptr<ShortenedLink> getLinkByShortCode(const std::string& code);
+
+    // --- Dedupe (DEDUPE_LINKS) ---
+    // Serializes dedupe-then-create for the link's owner and url_hash only; an
+    // empty lock when dedupe is off. Hold it until the new link is stored.
+    LinkDedupeIndex::KeyLock lockLinkUrl(const ShortenedLink& link);
+    // The owner's newest live link to the same original_url, or nullptr
+    std::unique_ptr<ShortenedLink> findDuplicateLink(const ShortenedLink& link);
     
     // Link Analytics (Click Tracking)
     bool incrementLinkClicks(unsigned int link_id); 
+    bool addLinkClicks(const std::vector<std::pair<unsigned int, unsigned long long>>& deltas); // batched (link_id, delta)
     bool incrementEndpointStat(const std::string& endpoint, const std::string& method, const std::string& createdBy);
+    bool addEndpointStats(const std::vector<EndpointStat>& stats); // batched upsert of count deltas
     
     // Link Management Dashboard (Read All Links by User)
     std::unique_ptr<std::vector<ShortenedLink>> getLinksByUserId(unsigned int user_id);
+    // Calls onRow for the user's links, newest first (created_at DESC, id DESC),
+    // starting after `after` (nullptr = from the newest), at most `limit` rows
+    // (0 = all). onRow returning false stops early. False on DB error.
+    bool forEachUserLink(unsigned int user_id, const LinkCursor* after, size_t limit,
+                         const std::function<bool(const ShortenedLink&)>& onRow);
 
     // --- Quota Management ---
     bool isQuotaLimitEnabled();
     bool checkAndUpdateGuestQuota(const std::string& guest_identifier, const std::string& today_date);
+    // Stored usage of every guest on `date`; nullptr on failure
+    std::unique_ptr<std::vector<GuestQuota>> getGuestQuotas(const std::string& date);
+    // Adds (guest, links) deltas for `date` in one transaction and fills `totals` with the
+    // stored counts afterwards; on failure nothing is added and `totals` is empty
+    bool addGuestQuotaUsage(const std::string& date, const std::vector<std::pair<std::string, unsigned int>>& deltas,
+                            std::unordered_map<std::string, unsigned int>& totals);
 
-    // global settings
+    // global settings, served from the in-memory snapshot (no I/O)
     std::string getConfig(std::string key);
-    std::string getConfig(mysqlx::Session& currentSession, std::string key);
+    std::shared_ptr<const GlobalSettingsSnapshot> getSettings() const;
+    bool reloadGlobalSettings(); // Admin trigger; false keeps the previous snapshot
+    // Every global_settings row, read from the primary; nullptr on failure
+    std::unique_ptr<std::vector<GlobalSetting>> getGlobalSettings();
     
     bool setLinkFavorite(const int&userId, const std::string&code, const bool&isFav);
     
@@ -91,4 +224,16 @@ public:
     
     void returnConnection(std::unique_ptr<mysqlx::Session> session);
 
+    const LinkCache* getLinkCache() const { return linkCache.get(); }
+    const LinkDedupeIndex* getLinkDedupe() const { return linkDedupe.get(); }
+    const SessionCache* getSessionCache() const { return sessionCache.get(); }
+    const StatementCacheStats& getStatementCacheStats() const { return statementStats; }
+    const ConnectionPool* getConnectionPool() const { return pool.get(); }
+    const GuestQuotaCounter* getGuestQuotaCounter() const { return guestQuota.get(); }
+    const ReplicaRouter* getReplicaRouter() const { return replicaRouter.get(); }
+    // Server-side prepares done by the X plugin (Mysqlx_prep_prepare), -1 if unavailable
+    long long getServerPrepareCount();
+    const ShortCodeFilter* getShortCodeFilter() const { return codeFilter.get(); }
+    const ShortCodeFilterSync* getShortCodeFilterSync() const { return codeFilterSync.get(); }
+
 };
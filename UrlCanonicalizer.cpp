@@ -0,0 +1,497 @@
+#include "UrlCanonicalizer.h"
+
+#include <arpa/inet.h>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+
+// The SSSE3 scan is compiled on every x86 build and picked at runtime, so
+// the default build flags (no -mssse3/-march) still use it
+#if defined(__x86_64__) || defined(__i386__)
+#define URL_SCAN_SSSE3 1
+#include <tmmintrin.h>
+#endif
+
+using Result = UrlCanonicalizer::Result;
+
+namespace {
+
+const char HEX_UPPER[] = "0123456789ABCDEF";
+
+constexpr bool isAlpha(unsigned char c) { return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z'); }
+constexpr bool isDigit(unsigned char c) { return c >= '0' && c <= '9'; }
+
+constexpr bool isUnreserved(unsigned char c) {
+    return isAlpha(c) || isDigit(c) || c == '-' || c == '.' || c == '_' || c == '~';
+}
+
+// Bytes copied as they are in a path, query or fragment: unreserved,
+// sub-delims, ':', '@' and '/'. Everything else takes the slow path.
+constexpr bool isPlain(unsigned char c) {
+    if (isUnreserved(c)) return true;
+    switch (c) {
+        case '!': case '$': case '&': case '\'': case '(': case ')': case '*': case '+':
+        case ',': case ';': case '=': case ':': case '@': case '/':
+            return true;
+        default:
+            return false;
+    }
+}
+
+// Character-class tables. plain[] is the scalar lookup. lo/hi are the same
+// set as nibble tables for a 16-byte shuffle lookup: byte c is plain when
+// lo[c & 15] & hi[c >> 4] is non-zero (only ASCII rows have a bit in hi).
+struct CharTables {
+    bool plain[256];
+    alignas(16) uint8_t lo[16];
+    alignas(16) uint8_t hi[16];
+};
+
+constexpr CharTables makeCharTables() {
+    CharTables t{};
+    for (int c = 0; c < 256; ++c) {
+        t.plain[c] = isPlain(static_cast<unsigned char>(c));
+        if (c < 128 && t.plain[c]) t.lo[c & 15] |= static_cast<uint8_t>(1u << (c >> 4));
+    }
+    for (int h = 0; h < 8; ++h) t.hi[h] = static_cast<uint8_t>(1u << h);
+    return t;
+}
+
+constexpr CharTables CHARS = makeCharTables();
+
+#if defined(URL_SCAN_SSSE3)
+// 16 bytes per step; returns the first non-plain index, or where the whole chunks end
+__attribute__((target("ssse3")))
+size_t scanPlainSsse3(const char* p, size_t i, size_t n) {
+    const __m128i lo = _mm_load_si128(reinterpret_cast<const __m128i*>(CHARS.lo));
+    const __m128i hi = _mm_load_si128(reinterpret_cast<const __m128i*>(CHARS.hi));
+    const __m128i nibble = _mm_set1_epi8(0x0f);
+    while (i + 16 <= n) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+        __m128i loBits = _mm_shuffle_epi8(lo, _mm_and_si128(chunk, nibble));
+        __m128i hiBits = _mm_shuffle_epi8(hi, _mm_and_si128(_mm_srli_epi16(chunk, 4), nibble));
+        __m128i notPlain = _mm_cmpeq_epi8(_mm_and_si128(loBits, hiBits), _mm_setzero_si128());
+        uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(notPlain));
+        if (mask) return i + __builtin_ctz(mask);
+        i += 16;
+    }
+    return i;
+}
+
+const bool CPU_HAS_SSSE3 = [] {
+    __builtin_cpu_init(); // Required before __builtin_cpu_supports during static initialization
+    return __builtin_cpu_supports("ssse3") != 0;
+}();
+#endif
+
+// Index of the first byte at or after i that is not plain, or n
+size_t scanPlain(const char* p, size_t i, size_t n) {
+#if defined(URL_SCAN_SSSE3)
+    if (CPU_HAS_SSSE3) i = scanPlainSsse3(p, i, n);
+#endif
+    while (i < n && CHARS.plain[static_cast<unsigned char>(p[i])]) ++i;
+    return i;
+}
+
+int hexValue(unsigned char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+char toLower(char c) {
+    return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+}
+
+// First index at or after i holding one of the delimiters, or text.size()
+size_t findDelimiter(std::string_view text, size_t i, bool slash, bool question) {
+    for (; i < text.size(); ++i) {
+        char c = text[i];
+        if (c == '#' || (question && c == '?') || (slash && c == '/')) return i;
+    }
+    return text.size();
+}
+
+bool equalsIgnoreCase(std::string_view a, std::string_view b) {
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (toLower(a[i]) != b[i]) return false;
+    }
+    return true;
+}
+
+void appendEscaped(std::string& out, unsigned char c) {
+    out += '%';
+    out += HEX_UPPER[c >> 4];
+    out += HEX_UPPER[c & 15];
+}
+
+// Path, query or fragment. '?' is literal in the query and the fragment.
+Result appendComponent(std::string_view part, bool questionAllowed, std::string& out) {
+    size_t i = 0;
+    while (i < part.size()) {
+        size_t run = scanPlain(part.data(), i, part.size());
+        out.append(part.data() + i, run - i);
+        i = run;
+        if (i == part.size()) break;
+
+        unsigned char c = static_cast<unsigned char>(part[i]);
+        if (c == '%') {
+            if (i + 2 >= part.size()) return Result::BadEscape;
+            int high = hexValue(part[i + 1]);
+            int low = hexValue(part[i + 2]);
+            if (high < 0 || low < 0) return Result::BadEscape;
+            unsigned char decoded = static_cast<unsigned char>(high * 16 + low);
+            if (isUnreserved(decoded)) {
+                out += static_cast<char>(decoded);
+            } else {
+                appendEscaped(out, decoded);
+            }
+            i += 3;
+        } else if (c < 0x20 || c == 0x7f) {
+            return Result::BadCharacter;
+        } else if (c == '?' && questionAllowed) {
+            out += '?';
+            ++i;
+        } else {
+            // Space, quotes, brackets, '\\', non-ASCII bytes, ...
+            appendEscaped(out, c);
+            ++i;
+        }
+    }
+    return Result::Ok;
+}
+
+// RFC 3986 5.2.4, in place on out[start..]; the path there starts with '/'
+void removeDotSegments(std::string& out, size_t start) {
+    size_t read = start;
+    size_t write = start;
+    const size_t end = out.size();
+    while (read < end) {
+        size_t next = out.find('/', read + 1);
+        if (next == std::string::npos) next = end;
+        std::string_view segment(out.data() + read + 1, next - read - 1);
+        const bool last = next == end;
+
+        if (segment == ".") {
+            if (last) out[write++] = '/';
+        } else if (segment == "..") {
+            if (write > start) {
+                size_t slash = out.rfind('/', write - 1);
+                write = (slash == std::string::npos || slash < start) ? start : slash;
+            }
+            if (last) out[write++] = '/';
+        } else {
+            std::memmove(&out[write], out.data() + read, next - read);
+            write += next - read;
+        }
+        read = next;
+    }
+    out.resize(write);
+    if (write == start) out += '/';
+}
+
+// UTF-8 to code points; false on malformed input or more than capacity code points
+bool decodeUtf8(std::string_view text, uint32_t* cps, size_t capacity, size_t& count) {
+    count = 0;
+    for (size_t i = 0; i < text.size();) {
+        unsigned char c = static_cast<unsigned char>(text[i]);
+        uint32_t cp;
+        size_t extra;
+        if (c < 0x80) { cp = c; extra = 0; }
+        else if (c >= 0xC2 && c <= 0xDF) { cp = c & 0x1F; extra = 1; }
+        else if (c >= 0xE0 && c <= 0xEF) { cp = c & 0x0F; extra = 2; }
+        else if (c >= 0xF0 && c <= 0xF4) { cp = c & 0x07; extra = 3; }
+        else return false;
+        if (i + extra >= text.size()) return false;
+        for (size_t k = 1; k <= extra; ++k) {
+            unsigned char cont = static_cast<unsigned char>(text[i + k]);
+            if ((cont & 0xC0) != 0x80) return false;
+            cp = (cp << 6) | (cont & 0x3F);
+        }
+        // Overlong forms, surrogates and values past U+10FFFF
+        if ((extra == 2 && cp < 0x800) || (extra == 3 && (cp < 0x10000 || cp > 0x10FFFF)) ||
+            (cp >= 0xD800 && cp <= 0xDFFF)) {
+            return false;
+        }
+        if (count == capacity) return false;
+        cps[count++] = cp;
+        i += extra + 1;
+    }
+    return true;
+}
+
+// RFC 3492 bias adaptation
+uint32_t adaptBias(uint32_t delta, uint32_t points, bool first) {
+    delta = first ? delta / 700 : delta / 2;
+    delta += delta / points;
+    uint32_t k = 0;
+    while (delta > ((36 - 1) * 26) / 2) {
+        delta /= 36 - 1;
+        k += 36;
+    }
+    return k + (36 * delta) / (delta + 38);
+}
+
+char punycodeDigit(uint32_t d) {
+    return static_cast<char>(d < 26 ? 'a' + d : '0' + (d - 26));
+}
+
+// RFC 3492 encoding of one label (without the "xn--" prefix)
+bool appendPunycode(const uint32_t* input, size_t length, std::string& out) {
+    size_t basic = 0;
+    for (size_t i = 0; i < length; ++i) {
+        if (input[i] < 0x80) {
+            out += static_cast<char>(input[i]);
+            ++basic;
+        }
+    }
+    if (basic > 0) out += '-';
+
+    uint32_t n = 0x80;
+    uint32_t delta = 0;
+    uint32_t bias = 72;
+    size_t handled = basic;
+    while (handled < length) {
+        uint32_t next = UINT32_MAX;
+        for (size_t i = 0; i < length; ++i) {
+            if (input[i] >= n && input[i] < next) next = input[i];
+        }
+        if ((next - n) > (UINT32_MAX - delta) / (handled + 1)) return false;
+        delta += (next - n) * static_cast<uint32_t>(handled + 1);
+        n = next;
+
+        for (size_t i = 0; i < length; ++i) {
+            if (input[i] < n && ++delta == 0) return false;
+            if (input[i] != n) continue;
+            uint32_t q = delta;
+            for (uint32_t k = 36;; k += 36) {
+                uint32_t t = k <= bias ? 1 : (k >= bias + 26 ? 26 : k - bias);
+                if (q < t) break;
+                out += punycodeDigit(t + (q - t) % (36 - t));
+                q = (q - t) / (36 - t);
+            }
+            out += punycodeDigit(q);
+            bias = adaptBias(delta, static_cast<uint32_t>(handled + 1), handled == basic);
+            delta = 0;
+            ++handled;
+        }
+        ++delta;
+        ++n;
+    }
+    return true;
+}
+
+bool isLabelChar(unsigned char c) {
+    return isAlpha(c) || isDigit(c) || c == '-' || c == '_';
+}
+
+// One DNS label, lower-cased; non-ASCII labels become xn--<punycode>
+bool appendLabel(std::string_view label, std::string& out) {
+    static constexpr size_t MAX_LABEL = 63;
+    if (label.empty() || label.front() == '-' || label.back() == '-') return false;
+
+    bool ascii = true;
+    for (char c : label) {
+        if (static_cast<unsigned char>(c) >= 0x80) {
+            ascii = false;
+            break;
+        }
+    }
+
+    const size_t labelStart = out.size();
+    if (ascii) {
+        for (char c : label) {
+            if (!isLabelChar(static_cast<unsigned char>(c))) return false;
+        }
+        out.append(label.data(), label.size());
+        for (size_t i = labelStart; i < out.size(); ++i) out[i] = toLower(out[i]);
+    } else {
+        uint32_t cps[MAX_LABEL];
+        size_t count = 0;
+        if (!decodeUtf8(label, cps, MAX_LABEL, count)) return false;
+        for (size_t i = 0; i < count; ++i) {
+            if (cps[i] < 0x80) {
+                if (!isLabelChar(static_cast<unsigned char>(cps[i]))) return false;
+                cps[i] = static_cast<unsigned char>(toLower(static_cast<char>(cps[i])));
+            }
+        }
+        out += "xn--";
+        if (!appendPunycode(cps, count, out)) return false;
+    }
+    return out.size() - labelStart <= MAX_LABEL;
+}
+
+// Dotted-quad IPv4 with every octet in 0..255 and no leading zeros
+// (a leading zero means octal to some resolvers)
+bool appendIPv4(std::string_view host, std::string& out) {
+    int parts = 0;
+    size_t i = 0;
+    while (true) {
+        size_t dot = host.find('.', i);
+        std::string_view part = host.substr(i, dot == std::string_view::npos ? std::string_view::npos : dot - i);
+        if (part.empty() || part.size() > 3 || (part.size() > 1 && part[0] == '0')) return false;
+        unsigned value = 0;
+        for (char c : part) {
+            if (!isDigit(static_cast<unsigned char>(c))) return false;
+            value = value * 10 + (c - '0');
+        }
+        if (value > 255) return false;
+        ++parts;
+        if (dot == std::string_view::npos) break;
+        i = dot + 1;
+    }
+    if (parts != 4) return false;
+    out.append(host.data(), host.size());
+    return true;
+}
+
+bool appendHost(std::string_view host, std::string& out) {
+    static constexpr size_t MAX_HOST = 253;
+    if (host.empty()) return false;
+
+    if (host.front() == '[') {
+        // IPv6 literal; zone ids and IPvFuture are not accepted
+        if (host.back() != ']' || host.size() < 4 || host.size() > 2 + INET6_ADDRSTRLEN) return false;
+        char text[INET6_ADDRSTRLEN + 1];
+        std::memcpy(text, host.data() + 1, host.size() - 2);
+        text[host.size() - 2] = '\0';
+        unsigned char address[16];
+        if (inet_pton(AF_INET6, text, address) != 1) return false;
+        char canonical[INET6_ADDRSTRLEN];
+        if (!inet_ntop(AF_INET6, address, canonical, sizeof(canonical))) return false;
+        out += '[';
+        out += canonical;
+        out += ']';
+        return true;
+    }
+
+    if (host.back() == '.') host.remove_suffix(1); // Fully qualified form, same host
+    if (host.empty()) return false;
+
+    // A numeric last label only makes sense as an IPv4 address
+    size_t lastDot = host.rfind('.');
+    std::string_view lastLabel = host.substr(lastDot == std::string_view::npos ? 0 : lastDot + 1);
+    bool numeric = !lastLabel.empty();
+    for (char c : lastLabel) {
+        if (!isDigit(static_cast<unsigned char>(c))) numeric = false;
+    }
+    if (numeric) return appendIPv4(host, out);
+
+    const size_t hostStart = out.size();
+    size_t i = 0;
+    while (true) {
+        size_t dot = host.find('.', i);
+        std::string_view label = host.substr(i, dot == std::string_view::npos ? std::string_view::npos : dot - i);
+        if (!appendLabel(label, out)) return false;
+        if (dot == std::string_view::npos) break;
+        out += '.';
+        i = dot + 1;
+    }
+    return out.size() - hostStart <= MAX_HOST;
+}
+
+// Appends ":port" unless the port is empty or the scheme's default
+bool appendPort(std::string_view port, unsigned defaultPort, std::string& out) {
+    if (port.empty()) return true;
+    unsigned value = 0;
+    for (char c : port) {
+        if (!isDigit(static_cast<unsigned char>(c))) return false;
+        value = value * 10 + (c - '0');
+        if (value > 65535) return false;
+    }
+    if (value == 0) return false;
+    if (value == defaultPort) return true;
+
+    char digits[8];
+    auto result = std::to_chars(digits, digits + sizeof(digits), value);
+    out += ':';
+    out.append(digits, result.ptr);
+    return true;
+}
+
+} // namespace
+
+Result UrlCanonicalizer::canonicalize(std::string_view url, std::string& out, size_t maxLength) {
+    out.clear();
+    if (url.empty()) return Result::Empty;
+    if (url.size() > maxLength) return Result::TooLong;
+
+    // scheme "://"
+    size_t colon = url.find(':');
+    if (colon == std::string_view::npos) return Result::BadScheme;
+    std::string_view scheme = url.substr(0, colon);
+    unsigned defaultPort;
+    if (equalsIgnoreCase(scheme, "http")) {
+        out += "http://";
+        defaultPort = 80;
+    } else if (equalsIgnoreCase(scheme, "https")) {
+        out += "https://";
+        defaultPort = 443;
+    } else {
+        return Result::BadScheme;
+    }
+    if (url.compare(colon + 1, 2, "//") != 0) return Result::BadScheme;
+    std::string_view rest = url.substr(colon + 3);
+
+    // authority = host [":" port]
+    size_t authorityEnd = findDelimiter(rest, 0, true, true);
+    std::string_view authority = rest.substr(0, authorityEnd);
+    if (authority.find('@') != std::string_view::npos) return Result::UserInfo;
+
+    std::string_view host = authority;
+    std::string_view port;
+    size_t portColon = authority.rfind(':');
+    if (portColon != std::string_view::npos && authority.find(']', portColon) == std::string_view::npos) {
+        host = authority.substr(0, portColon);
+        port = authority.substr(portColon + 1);
+    }
+    if (!appendHost(host, out)) return Result::BadHost;
+    if (!appendPort(port, defaultPort, out)) return Result::BadPort;
+
+    // path, then "?" query, then "#" fragment
+    rest.remove_prefix(authorityEnd);
+    size_t pathEnd = findDelimiter(rest, 0, false, true);
+
+    const size_t pathStart = out.size();
+    Result result = appendComponent(rest.substr(0, pathEnd), false, out);
+    if (result != Result::Ok) return result;
+    if (out.size() == pathStart) {
+        out += '/';
+    } else {
+        removeDotSegments(out, pathStart);
+    }
+    rest.remove_prefix(pathEnd);
+
+    if (!rest.empty() && rest.front() == '?') {
+        size_t queryEnd = findDelimiter(rest, 1, false, false);
+        out += '?';
+        result = appendComponent(rest.substr(1, queryEnd - 1), true, out);
+        if (result != Result::Ok) return result;
+        rest.remove_prefix(queryEnd);
+    }
+    if (!rest.empty() && rest.front() == '#') {
+        out += '#';
+        result = appendComponent(rest.substr(1), true, out);
+        if (result != Result::Ok) return result;
+    }
+
+    if (out.size() > maxLength) return Result::TooLong;
+    return Result::Ok;
+}
+
+const char* UrlCanonicalizer::describe(Result result) {
+    switch (result) {
+        case Result::Ok: return "ok";
+        case Result::Empty: return "empty URL";
+        case Result::TooLong: return "URL is too long";
+        case Result::BadScheme: return "only http:// and https:// URLs are accepted";
+        case Result::UserInfo: return "credentials in the URL are not accepted";
+        case Result::BadHost: return "invalid host";
+        case Result::BadPort: return "invalid port";
+        case Result::BadCharacter: return "control character in URL";
+        case Result::BadEscape: return "invalid percent-encoding";
+    }
+    return "invalid URL";
+}
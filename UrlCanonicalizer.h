@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+// Parses the absolute http(s) URLs accepted by /shorten (RFC 3986) and
+// rewrites them into one canonical spelling, so equal URLs are equal byte
+// for byte (link cache, dedupe).
+//
+// Canonical form:
+//  - scheme and host in lower case, internationalized host labels in
+//    punycode (xn--), IPv6 literals in their compressed form
+//  - default (80/443) and empty ports dropped, leading zeros removed
+//  - escapes of unreserved characters decoded, other escapes upper-cased,
+//    characters not allowed where they appear percent-encoded
+//  - "." and ".." path segments resolved, an empty path becomes "/"
+//
+// Rejected: other schemes, user:password@ (a common way to disguise the
+// real host), malformed hosts and ports, control characters and broken
+// escapes.
+//
+// The input is only read through string_views and the result is written to
+// out, which callers can keep reserved between calls. On x86 the character
+// class scan uses SSSE3 when the CPU has it (detected at startup, no build
+// flag needed) and falls back to a table lookup otherwise.
+class UrlCanonicalizer {
+public:
+    enum class Result { Ok, Empty, TooLong, BadScheme, UserInfo, BadHost, BadPort, BadCharacter, BadEscape };
+
+    // Replaces out with the canonical form of url; maxLength applies to both
+    static Result canonicalize(std::string_view url, std::string& out, size_t maxLength);
+
+    // Short reason for error responses
+    static const char* describe(Result result);
+};
@@ -7,10 +7,19 @@ echo "Starting C++ compilation..."
 # Note: /usr/include/mysqlx is where the header files are installed by the connector package.
 # We link against -lmysqlx -lssl -lcrypto -lpthread for MySQL/SSL support.
 g++ -std=c++17 -Wall -Wextra \
-    main.cpp Server.cpp URLShortnerDB.cpp Config.cpp \
+    main.cpp Server.cpp JsonReader.cpp JsonWriter.cpp UrlCanonicalizer.cpp SecureRandom.cpp Logger.cpp URLShortnerDB.cpp Config.cpp LinkCache.cpp SessionCache.cpp StatementCache.cpp ConnectionPool.cpp ReplicaRouter.cpp GlobalSettings.cpp GuestQuotaCounter.cpp ClickCounter.cpp LinkBatcher.cpp EndpointStats.cpp RateLimiter.cpp SessionToken.cpp RevocationList.cpp ShortCodeAllocator.cpp CodeReservoir.cpp ShortCodeFilter.cpp ShortCodeFilterSync.cpp LinkSnapshot.cpp LinkTombstones.cpp LinkDedupe.cpp \
     -o url_shortener \
+    -lmysqlx -lsentry -lssl -lcrypto -lpthread
+
+g++ -std=c++17 -Wall -Wextra \
+    tools/snapshot_gen.cpp URLShortnerDB.cpp Config.cpp LinkCache.cpp SessionCache.cpp StatementCache.cpp ConnectionPool.cpp ReplicaRouter.cpp GlobalSettings.cpp GuestQuotaCounter.cpp ShortCodeFilter.cpp ShortCodeFilterSync.cpp LinkSnapshot.cpp LinkTombstones.cpp LinkDedupe.cpp \
+    -o snapshot_gen \
     -lmysqlx -lssl -lcrypto -lpthread
 
+# Canonicalizer checks (punycode, dot segments, IPv6/ports, SSSE3 vs table scan)
+g++ -std=c++17 -Wall -Wextra tests/url_canonicalizer_test.cpp -o url_canonicalizer_test
+./url_canonicalizer_test
+
 echo "Compilation finished successfully."
 
 # Ensure the executable has run permissions
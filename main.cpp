@@ -14,6 +14,10 @@
 #include <iostream>
 #include <string>
 #include <mutex>
+#include <thread>
+#include <csignal>
+#include <pthread.h>
+#include <sentry.h>
 #include "Config.h"     // Configuration constants
 #include "URLShortnerDB.h" // Database handler class
 #include "Server.h"     // HTTP Server handler class
@@ -28,17 +32,10 @@ using namespace httplib;
  * This object manages the connection and operations with the underlying database.
  * It is defined globally so its reference can be passed to the UrlShortenerServer
  * instance, allowing all server handlers to interact with the database.
+ * All of its methods are thread-safe on top of the connection pool.
  */
 UrlShortenerDB db;
 
-/**
- * @brief Global mutex for database synchronization.
- * This mutex is used to protect concurrent access to the 'db' instance
- * from multiple threads that the httplib server uses to handle requests,
- * ensuring thread-safe database operations.
- */
-mutex dbMutex;
-
 // --- Main Entry Point ---
 
 /**
@@ -49,6 +46,22 @@ int main() {
     // Output application status to standard error for logging purposes
     cerr << "RUNNING: Starting URL Shortener Service initialization..." << endl;
 
+    // Block SIGINT/SIGTERM before any other thread starts (Sentry's transport, the
+    // DB pool and its background refreshers all inherit this mask) so that only
+    // the dedicated signal thread below receives them.
+    sigset_t shutdownSignals;
+    sigemptyset(&shutdownSignals);
+    sigaddset(&shutdownSignals, SIGINT);
+    sigaddset(&shutdownSignals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &shutdownSignals, nullptr);
+
+    // Sentry is optional; the request logger only forwards events when it is initialized
+    if (!Config::SENTRY_DSN.empty()) {
+        sentry_options_t* options = sentry_options_new();
+        sentry_options_set_dsn(options, Config::SENTRY_DSN.c_str());
+        sentry_init(options);
+    }
+
     // 1. Initialize Database (Connect and Ensure Schema exists)
     // Attempt to connect to the configured MySQL server and verify/setup the necessary tables.
     if (!db.connect() || !db.setupDatabase()) {
@@ -56,15 +69,38 @@ int main() {
         return 1;
     }
 
+    // Build the short code existence filter; on failure lookups simply fall back to the DB
+    db.loadShortCodeFilter();
+
+    // Map the immutable link snapshot, if configured (redirects keep working from it while MySQL is slow)
+    if (!Config::LINK_SNAPSHOT_PATH.empty() && !db.openLinkSnapshot(Config::LINK_SNAPSHOT_PATH)) {
+        cerr << "WARN: Link snapshot not loaded, redirects will use the database only." << endl;
+    }
+
     // 2. Initialize the Server Application
     // The UrlShortenerServer class encapsulates all routes, middleware, and handlers.
-    // It is constructed with references to the database instance and its protective mutex.
-    UrlShortenerServer app(db, dbMutex);
+    // It is constructed with a reference to the database instance, which is safe to share
+    // between handler threads (every call checks out its own pooled session).
+    UrlShortenerServer app(db);
+
+    // Graceful shutdown: stop the server on SIGINT/SIGTERM so that buffered
+    // data (e.g. pending click counts) is flushed before the process exits.
+    thread([&app, shutdownSignals]() {
+        int signal = 0;
+        sigwait(&shutdownSignals, &signal);
+        cerr << "Received signal " << signal << ", shutting down..." << endl;
+        app.stop();
+    }).detach();
 
     // 3. Run the Server
     // Start listening on the configured host and port.
     cerr << "Listening on http://0.0.0.0:9080" << endl;
-    if (!app.run()) {
+    bool ran = app.run();
+
+    // Flush queued Sentry events
+    if (!Config::SENTRY_DSN.empty()) sentry_close();
+
+    if (!ran) {
         cerr << "FATAL: Server failed to start or shut down unexpectedly." << endl;
         return 1;
     }
@@ -23,7 +23,22 @@ CREATE TABLE IF NOT EXISTS users (id INT UNSIGNED NOT NULL AUTO_INCREMENT,google
 
 -- -----------------------------------------------------
 ;
-CREATE TABLE IF NOT EXISTS sessions (id INT UNSIGNED NOT NULL AUTO_INCREMENT,user_id INT UNSIGNED NOT NULL COMMENT 'Foreign key linking to the users table',session_token VARCHAR(255) NOT NULL COMMENT 'The secure token passed to the frontend',expires_at DATETIME NOT NULL COMMENT 'Timestamp when the session becomes invalid (1 day)',created_at DATETIME NOT NULL DEFAULT CURRENT_TIMESTAMP,updated_at DATETIME NOT NULL DEFAULT CURRENT_TIMESTAMP ON UPDATE CURRENT_TIMESTAMP,PRIMARY KEY (id),UNIQUE INDEX ux_session_token (session_token),CONSTRAINT fk_sessions_user_id FOREIGN KEY (user_id)REFERENCES users (id)ON DELETE CASCADE) ENGINE=InnoDB DEFAULT CHARSET=utf8mb4;
+CREATE TABLE IF NOT EXISTS sessions (id INT UNSIGNED NOT NULL AUTO_INCREMENT,user_id INT UNSIGNED NOT NULL COMMENT 'Foreign key linking to the users table',session_token VARCHAR(255) NOT NULL COMMENT 'The secure token passed to the frontend',expires_at DATETIME NOT NULL COMMENT 'Timestamp when the session becomes invalid (1 day)',revoked_at DATETIME NULL DEFAULT NULL COMMENT 'Set on logout, signed tokens stay revoked until they expire',created_at DATETIME NOT NULL DEFAULT CURRENT_TIMESTAMP,updated_at DATETIME NOT NULL DEFAULT CURRENT_TIMESTAMP ON UPDATE CURRENT_TIMESTAMP,PRIMARY KEY (id),UNIQUE INDEX ux_session_token (session_token),INDEX ix_revoked_expires (revoked_at, expires_at),INDEX ix_expires_at (expires_at),CONSTRAINT fk_sessions_user_id FOREIGN KEY (user_id)REFERENCES users (id)ON DELETE CASCADE) ENGINE=InnoDB DEFAULT CHARSET=utf8mb4;
+
+-- Existing databases: add the revocation column (fails harmlessly once it exists)
+;
+ALTER TABLE sessions ADD COLUMN revoked_at DATETIME NULL DEFAULT NULL COMMENT 'Set on logout, signed tokens stay revoked until they expire';
+
+-- Existing databases: indexes for the revocation sync and the expired-session purge (fail harmlessly once they exist)
+;
+ALTER TABLE sessions ADD INDEX ix_revoked_expires (revoked_at, expires_at);
+;
+ALTER TABLE sessions ADD INDEX ix_expires_at (expires_at);
+
+-- Existing databases: signed tokens were issued for 30 days while their rows expired after 12 hours,
+-- so keep revoked rows as long as the tokens themselves (no-op once fixed)
+;
+UPDATE sessions SET expires_at = created_at + INTERVAL 30 DAY WHERE revoked_at IS NOT NULL AND session_token LIKE 'v1.%' AND expires_at < created_at + INTERVAL 30 DAY;
 
 -- -----------------------------------------------------
 
@@ -33,8 +48,42 @@ CREATE TABLE IF NOT EXISTS sessions (id INT UNSIGNED NOT NULL AUTO_INCREMENT,use
 
 -- -----------------------------------------------------
 ;
-CREATE TABLE IF NOT EXISTS shortened_links (id INT UNSIGNED NOT NULL AUTO_INCREMENT,original_url TEXT NOT NULL COMMENT 'The full URL to redirect to',short_code VARCHAR(10) NOT NULL COMMENT 'The unique, short identifier (e.g., 6 characters)',user_id INT UNSIGNED NULL COMMENT 'ID of the authenticated creator (NULL if created by guest)',guest_identifier VARCHAR(255) NULL COMMENT 'IP or fingerprint for unauthenticated users',expires_at DATETIME NULL COMMENT 'Optional expiry date/time after which the link fails', is_favourite BOOLEAN DEFAULT FALSE, clicks INT UNSIGNED NOT NULL DEFAULT 0,created_at DATETIME NOT NULL DEFAULT CURRENT_TIMESTAMP,updated_at DATETIME NOT NULL DEFAULT CURRENT_TIMESTAMP ON UPDATE CURRENT_TIMESTAMP,PRIMARY KEY (id),UNIQUE INDEX ux_short_code (short_code),CONSTRAINT fk_links_user_id FOREIGN KEY (user_id)REFERENCES users (id)ON DELETE SET NULL) ENGINE=InnoDB DEFAULT CHARSET=utf8mb4;
+CREATE TABLE IF NOT EXISTS shortened_links (id INT UNSIGNED NOT NULL AUTO_INCREMENT,original_url TEXT NOT NULL COMMENT 'The full URL to redirect to',short_code VARCHAR(10) NOT NULL COMMENT 'The unique, short identifier (e.g., 6 characters)',user_id INT UNSIGNED NULL COMMENT 'ID of the authenticated creator (NULL if created by guest)',guest_identifier VARCHAR(255) NULL COMMENT 'IP or fingerprint for unauthenticated users',expires_at DATETIME NULL COMMENT 'Optional expiry date/time after which the link fails',url_hash BIGINT UNSIGNED NULL COMMENT '64-bit hash of the canonical original_url (dedupe)', is_favourite BOOLEAN DEFAULT FALSE, clicks INT UNSIGNED NOT NULL DEFAULT 0,created_at DATETIME NOT NULL DEFAULT CURRENT_TIMESTAMP,updated_at DATETIME NOT NULL DEFAULT CURRENT_TIMESTAMP ON UPDATE CURRENT_TIMESTAMP,PRIMARY KEY (id),UNIQUE INDEX ux_short_code (short_code),INDEX ix_user_created_id (user_id, created_at, id),INDEX ix_url_hash (url_hash),CONSTRAINT fk_links_user_id FOREIGN KEY (user_id)REFERENCES users (id)ON DELETE SET NULL) ENGINE=InnoDB DEFAULT CHARSET=utf8mb4;
 
+-- Existing databases: keyset pagination index for /api/links (fails harmlessly once it exists)
+;
+ALTER TABLE shortened_links ADD INDEX ix_user_created_id (user_id, created_at, id);
+
+-- Existing databases: url hash for DEDUPE_LINKS (fails harmlessly once it exists)
+;
+ALTER TABLE shortened_links ADD COLUMN url_hash BIGINT UNSIGNED NULL COMMENT '64-bit hash of the canonical original_url (dedupe)';
+;
+ALTER TABLE shortened_links ADD INDEX ix_url_hash (url_hash);
+
+
+
+-- -----------------------------------------------------
+
+-- Table structure for 'deleted_codes'
+
+-- Tombstones of deleted links, so instances serving an older link snapshot stop serving them
+
+-- -----------------------------------------------------
+;
+CREATE TABLE IF NOT EXISTS deleted_codes (id BIGINT UNSIGNED NOT NULL AUTO_INCREMENT,short_code VARCHAR(10) NOT NULL COMMENT 'Code of the deleted link',deleted_at DATETIME NOT NULL DEFAULT CURRENT_TIMESTAMP,PRIMARY KEY (id),INDEX ix_deleted_at (deleted_at)) ENGINE=InnoDB DEFAULT CHARSET=utf8mb4;
+
+
+-- -----------------------------------------------------
+
+-- Table structure for 'id_sequences'
+
+-- Block-leased id counters (short codes are allocated from the 'short_code' row)
+
+-- -----------------------------------------------------
+;
+CREATE TABLE IF NOT EXISTS id_sequences (name VARCHAR(50) NOT NULL COMMENT 'Sequence name',next_value BIGINT UNSIGNED NOT NULL DEFAULT 1 COMMENT 'First id of the next block to lease',updated_at DATETIME NOT NULL DEFAULT CURRENT_TIMESTAMP ON UPDATE CURRENT_TIMESTAMP,PRIMARY KEY (name)) ENGINE=InnoDB DEFAULT CHARSET=utf8mb4;
+;
+INSERT INTO id_sequences (name, next_value) VALUES ('short_code', 1) ON DUPLICATE KEY UPDATE next_value=next_value;
 
 
 -- -----------------------------------------------------
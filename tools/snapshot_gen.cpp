@@ -0,0 +1,62 @@
+/**
+ * @file snapshot_gen.cpp
+ * @brief Generator for the memory-mapped link snapshot used by the server.
+ *
+ * Streams every non-expired row of shortened_links out of MySQL (same
+ * credentials/environment as the server) and writes the immutable
+ * snapshot file with its minimal perfect hash index. The file is written
+ * to a temporary path and renamed, so it can be regenerated next to a
+ * running server; restart the server (or workers) to pick it up.
+ *
+ * Usage: snapshot_gen [output_path]   (defaults to LINK_SNAPSHOT_PATH)
+ */
+
+#include <ctime>
+#include <iostream>
+#include <string>
+
+#include "../Config.h"
+#include "../LinkSnapshot.h"
+#include "../URLShortnerDB.h"
+
+using namespace std;
+
+int main(int argc, char* argv[]) {
+    string outputPath = argc > 1 ? argv[1] : Config::LINK_SNAPSHOT_PATH;
+    if (outputPath.empty()) {
+        cerr << "Usage: " << argv[0] << " <output_path>  (or set LINK_SNAPSHOT_PATH)" << endl;
+        return 1;
+    }
+
+    UrlShortenerDB db;
+    if (!db.connect()) {
+        cerr << "FATAL: Database connection failed." << endl;
+        return 1;
+    }
+
+    LinkSnapshotWriter writer;
+    writer.setCreatedAt(time(nullptr));
+    bool streamed = db.forEachLiveLink([&writer](const ShortenedLink& link) {
+        SnapshotLink entry;
+        entry.id = link.id;
+        entry.user_id = link.user_id ? *link.user_id : 0;
+        entry.expires_epoch = UrlShortenerDB::parseTimestamp(link.expires_at);
+        entry.short_code = link.short_code;
+        entry.original_url = link.original_url;
+        writer.add(std::move(entry));
+    });
+
+    if (!streamed) {
+        cerr << "FATAL: Failed to read shortened_links." << endl;
+        return 1;
+    }
+
+    cerr << "Writing " << writer.size() << " links to " << outputPath << "..." << endl;
+    if (!writer.write(outputPath)) {
+        cerr << "FATAL: Snapshot generation failed." << endl;
+        return 1;
+    }
+
+    cerr << "Snapshot written to " << outputPath << endl;
+    return 0;
+}